@@ -0,0 +1,188 @@
+/** \file herwig7CompactEvents.cpp
+ *
+ *  Conversion between HepMC ascii and compact event files, and a comparison
+ *  of their size and read/write speed.
+ *
+ *  herwig7CompactEvents tohepmc   <in.h7ce>  <out.hepmc> [first [count]]
+ *  herwig7CompactEvents fromhepmc <in.hepmc> <out.h7ce>  [--quantize]
+ *  herwig7CompactEvents bench     <in.hepmc>
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <sys/stat.h>
+
+#include <HepMC/GenEvent.h>
+#include <HepMC/IO_GenEvent.h>
+
+#include "GeneratorInterface/Herwig7Interface/interface/CompactEventIO.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double seconds(Clock::time_point start)
+{
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+static long fileSize(const string &fileName)
+{
+	struct stat st;
+	return stat(fileName.c_str(), &st) ? -1 : st.st_size;
+}
+
+static long copyEvents(HepMC::IO_BaseClass &in, HepMC::IO_BaseClass &out, long count = -1)
+{
+	long n = 0;
+	for (; count < 0 || n < count; ++n) {
+		HepMC::GenEvent event;
+		if (!in.fill_next_event(&event))
+			break;
+		out.write_event(&event);
+	}
+	return n;
+}
+
+static long readEvents(HepMC::IO_BaseClass &in)
+{
+	long n = 0;
+	HepMC::GenEvent event;
+	while (in.fill_next_event(&event)) {
+		event.clear();
+		++n;
+	}
+	return n;
+}
+
+static int toHepMC(int argc, char **argv)
+{
+	CompactEventIO in(argv[2], ios::in);
+	if (argc > 4 && !in.seek(strtoull(argv[4], 0, 10))) {
+		cerr << "File " << argv[2] << " has only " << in.size() << " events" << endl;
+		return 1;
+	}
+	HepMC::IO_GenEvent out(argv[3], ios::out);
+	long n = copyEvents(in, out, argc > 5 ? atol(argv[5]) : -1);
+	cout << n << " events written to " << argv[3] << endl;
+	return 0;
+}
+
+static int fromHepMC(int argc, char **argv)
+{
+	bool quantize = argc > 4 && string(argv[4]) == "--quantize";
+	HepMC::IO_GenEvent in(argv[2], ios::in);
+	CompactEventIO out(argv[3], ios::out, quantize);
+	long n = copyEvents(in, out);
+	out.close();
+	cout << n << " events written to " << argv[3] << endl;
+	return 0;
+}
+
+static int bench(char **argv)
+{
+	string input = argv[2];
+	string exact = input + ".bench.h7ce";
+	string quantized = input + ".bench.q.h7ce";
+	string ascii = input + ".bench.hepmc";
+
+	Clock::time_point start = Clock::now();
+	long events;
+	{
+		HepMC::IO_GenEvent in(input.c_str(), ios::in);
+		HepMC::IO_GenEvent out(ascii.c_str(), ios::out);
+		events = copyEvents(in, out);
+	}
+	double asciiWrite = seconds(start);
+	if (!events) {
+		cerr << "No events in " << input << endl;
+		return 1;
+	}
+
+	start = Clock::now();
+	{
+		HepMC::IO_GenEvent in(input.c_str(), ios::in);
+		CompactEventIO out(exact, ios::out);
+		copyEvents(in, out);
+	}
+	double exactWrite = seconds(start);
+
+	start = Clock::now();
+	{
+		HepMC::IO_GenEvent in(input.c_str(), ios::in);
+		CompactEventIO out(quantized, ios::out, true);
+		copyEvents(in, out);
+	}
+	double quantizedWrite = seconds(start);
+
+	// Writing includes reading the input once, measure the reads separately
+	start = Clock::now();
+	{
+		HepMC::IO_GenEvent in(ascii.c_str(), ios::in);
+		readEvents(in);
+	}
+	double asciiRead = seconds(start);
+	start = Clock::now();
+	{
+		CompactEventIO in(exact, ios::in);
+		readEvents(in);
+	}
+	double exactRead = seconds(start);
+	start = Clock::now();
+	{
+		CompactEventIO in(quantized, ios::in);
+		readEvents(in);
+	}
+	double quantizedRead = seconds(start);
+
+	start = Clock::now();
+	{
+		CompactEventIO in(exact, ios::in);
+		HepMC::GenEvent event;
+		in.seek(events - 1);
+		in.fill_next_event(&event);
+	}
+	double lastEvent = seconds(start);
+
+	cout << events << " events" << endl
+	     << "format       size/event [B]  write [ms/event]  read [ms/event]" << endl;
+	const char *names[3] = { "ascii     ", "compact   ", "compact/q " };
+	string files[3] = { ascii, exact, quantized };
+	double writes[3] = { asciiWrite, exactWrite, quantizedWrite };
+	double reads[3] = { asciiRead, exactRead, quantizedRead };
+	for (int i = 0; i < 3; ++i)
+		cout << names[i] << "   " << double(fileSize(files[i])) / events
+		     << "   " << 1e3 * writes[i] / events << "   " << 1e3 * reads[i] / events << endl;
+	cout << "random access to the last event: " << 1e3 * lastEvent << " ms" << endl;
+
+	remove(ascii.c_str());
+	remove(exact.c_str());
+	remove(quantized.c_str());
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	string mode = argc > 1 ? argv[1] : "";
+	try {
+		if (mode == "tohepmc" && argc > 3)
+			return toHepMC(argc, argv);
+		if (mode == "fromhepmc" && argc > 3)
+			return fromHepMC(argc, argv);
+		if (mode == "bench" && argc > 2)
+			return bench(argv);
+	} catch (std::exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	cerr << "Usage: " << argv[0] << " tohepmc <in.h7ce> <out.hepmc> [first [count]]" << endl
+	     << "       " << argv[0] << " fromhepmc <in.hepmc> <out.h7ce> [--quantize]" << endl
+	     << "       " << argv[0] << " bench <in.hepmc>" << endl;
+	return 1;
+}
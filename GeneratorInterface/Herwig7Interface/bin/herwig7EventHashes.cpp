@@ -0,0 +1,190 @@
+/** \file herwig7EventHashes.cpp
+ *
+ *  Event by event comparison of two runs through their content hashes.
+ *  Several files of one run, e.g. of parallel jobs, are given separated by
+ *  commas. Event files (HepMC ascii or compact) can be given instead of
+ *  hash files, their events are hashed on the fly.
+ *
+ *  herwig7EventHashes hash    <events.hepmc|events.h7ce> <out.hashes>
+ *  herwig7EventHashes compare <a.hashes|events>[,...] <b.hashes|events>[,...] [--unordered]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <HepMC/GenEvent.h>
+#include <HepMC/IO_GenEvent.h>
+
+#include "GeneratorInterface/Herwig7Interface/interface/CompactEventIO.h"
+#include "GeneratorInterface/Herwig7Interface/interface/EventContentHash.h"
+
+using namespace std;
+
+struct Entry {
+	long long	number;
+	uint64_t	hash;
+};
+
+static const size_t maxReported = 10;
+
+static vector<string> split(const string &list)
+{
+	vector<string> files;
+	istringstream in(list);
+	string file;
+	while (getline(in, file, ','))
+		if (!file.empty())
+			files.push_back(file);
+	return files;
+}
+
+static bool isCompact(const string &fileName)
+{
+	char magic[4] = { 0, 0, 0, 0 };
+	ifstream in(fileName.c_str(), ios::in | ios::binary);
+	in.read(magic, sizeof(magic));
+	return memcmp(magic, "H7CE", sizeof(magic)) == 0;
+}
+
+// IO_GenEvent files start with the HepMC version line
+static bool isAscii(const string &fileName)
+{
+	ifstream in(fileName.c_str());
+	string line;
+	while (getline(in, line))
+		if (!line.empty())
+			return line.compare(0, 7, "HepMC::") == 0;
+	return false;
+}
+
+static auto_ptr<HepMC::IO_BaseClass> openEvents(const string &fileName)
+{
+	auto_ptr<HepMC::IO_BaseClass> in;
+	if (isCompact(fileName))
+		in.reset(new CompactEventIO(fileName, ios::in));
+	else
+		in.reset(new HepMC::IO_GenEvent(fileName.c_str(), ios::in));
+	return in;
+}
+
+static vector<Entry> readHashes(const string &list)
+{
+	vector<Entry> entries;
+	vector<string> files = split(list);
+	for (vector<string>::const_iterator file = files.begin(); file != files.end(); ++file) {
+		Entry entry;
+		if (isCompact(*file) || isAscii(*file)) {
+			auto_ptr<HepMC::IO_BaseClass> in = openEvents(*file);
+			HepMC::GenEvent event;
+			while (in->fill_next_event(&event)) {
+				entry.number = event.event_number();
+				entry.hash = EventContentHash::hash(event);
+				entries.push_back(entry);
+				event.clear();
+			}
+			continue;
+		}
+		ifstream in(file->c_str());
+		if (!in)
+			throw runtime_error("Cannot read " + *file);
+		while (EventContentHash::read(in, entry.number, entry.hash))
+			entries.push_back(entry);
+	}
+	return entries;
+}
+
+static int hashEvents(char **argv)
+{
+	auto_ptr<HepMC::IO_BaseClass> in = openEvents(argv[2]);
+
+	EventContentHash hashes(argv[3]);
+	HepMC::GenEvent event;
+	while (in->fill_next_event(&event)) {
+		hashes.add(event);
+		event.clear();
+	}
+	fprintf(stdout, "%llu events hashed to %s, combined hash %016llx\n", hashes.events(), argv[3],
+		(unsigned long long)hashes.combined());
+	return 0;
+}
+
+// Same sequence of events, the numbers may differ
+static int compareOrdered(const vector<Entry> &a, const vector<Entry> &b)
+{
+	size_t n = min(a.size(), b.size()), differing = 0;
+	for (size_t i = 0; i < n; ++i) {
+		if (a[i].hash == b[i].hash)
+			continue;
+		if (++differing <= maxReported)
+			cout << "event " << i << ": " << a[i].number << " and " << b[i].number << " differ" << endl;
+	}
+	cout << n << " events compared, " << differing << " differ";
+	if (a.size() != b.size())
+		cout << ", " << max(a.size(), b.size()) - n << " events only in the " << (a.size() > b.size() ? "first" : "second") << " run";
+	cout << endl;
+	return differing || a.size() != b.size() ? 1 : 0;
+}
+
+// Same set of events in any order, e.g. a run split into parallel jobs
+static int compareUnordered(const vector<Entry> &a, const vector<Entry> &b)
+{
+	map<uint64_t, long> count;
+	for (vector<Entry>::const_iterator it = a.begin(); it != a.end(); ++it)
+		++count[it->hash];
+	for (vector<Entry>::const_iterator it = b.begin(); it != b.end(); ++it)
+		--count[it->hash];
+
+	size_t onlyA = 0, onlyB = 0;
+	for (map<uint64_t, long>::const_iterator it = count.begin(); it != count.end(); ++it) {
+		if (it->second > 0)
+			onlyA += it->second;
+		else
+			onlyB -= it->second;
+	}
+	for (int run = 0; run < 2; ++run) {
+		const vector<Entry> &entries = run ? b : a;
+		size_t reported = 0;
+		for (vector<Entry>::const_iterator it = entries.begin(); it != entries.end() && reported < maxReported; ++it) {
+			long &left = count[it->hash];
+			if (run ? left < 0 : left > 0) {
+				cout << "event " << it->number << " only in the " << (run ? "second" : "first") << " run" << endl;
+				left += run ? 1 : -1;
+				++reported;
+			}
+		}
+	}
+	cout << a.size() << " and " << b.size() << " events compared, " << onlyA << " only in the first, "
+	     << onlyB << " only in the second run" << endl;
+	return onlyA || onlyB ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	string mode = argc > 1 ? argv[1] : "";
+	try {
+		if (mode == "hash" && argc > 3)
+			return hashEvents(argv);
+		if (mode == "compare" && argc > 3) {
+			vector<Entry> a = readHashes(argv[2]);
+			vector<Entry> b = readHashes(argv[3]);
+			if (argc > 4 && string(argv[4]) == "--unordered")
+				return compareUnordered(a, b);
+			return compareOrdered(a, b);
+		}
+	} catch (std::exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	cerr << "Usage: " << argv[0] << " hash <events.hepmc|events.h7ce> <out.hashes>" << endl
+	     << "       " << argv[0] << " compare <a.hashes|events>[,...] <b.hashes|events>[,...] [--unordered]" << endl;
+	return 1;
+}
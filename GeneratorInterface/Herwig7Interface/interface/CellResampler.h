@@ -0,0 +1,60 @@
+#ifndef GeneratorInterface_Herwig7Interface_CellResampler_h
+#define GeneratorInterface_Herwig7Interface_CellResampler_h
+
+/** \class CellResampler
+ *
+ * @brief Reduces negative event weights by resampling within phase-space cells
+ *
+ * Follows the cell resampling of Andersen and Maier: around every event
+ * with negative weight (the seed) a cell is grown from its nearest
+ * neighbours until the summed weight in the cell is no longer negative or
+ * the maximal cell radius is reached. The weights in the cell are then
+ * replaced by |w_i| * sum(w) / sum(|w|), which keeps the total weight of
+ * the cell, and with it all distributions at the resolution of the cell.
+ *
+ * Events are described by the momenta of the outgoing particles of the
+ * hard process. Only events with the same outgoing flavour classes are
+ * neighbours; their distance is the sum of the momentum differences of
+ * the particles of each class ordered in transverse momentum.
+ */
+
+#include <vector>
+
+class CellResampler {
+    public:
+	struct Particle {
+		int	type;
+		double	px, py, pz;
+	};
+
+	struct Event {
+		// Outgoing hard particles sorted by type and transverse momentum
+		std::vector<Particle>	particles;
+		double			weight;
+	};
+
+	// maxRadius <= 0 lets the cells grow without limit (in GeV)
+	CellResampler(double maxRadius);
+
+	static Event makeEvent(std::vector<Particle> particles, double weight);
+
+	// Resample the weights of the buffered events in place
+	void resample(std::vector<Event> &events);
+
+	// Effective sample size (sum w)^2 / sum w^2 of all resampled events
+	double effectiveSizeBefore() const { return essBefore_; }
+	double effectiveSizeAfter() const { return essAfter_; }
+	unsigned long long cells() const { return cells_; }
+
+	static double effectiveSize(const std::vector<Event> &events);
+
+    private:
+	static double distance(const Event &a, const Event &b);
+
+	const double		maxRadius_;
+	double			essBefore_;
+	double			essAfter_;
+	unsigned long long	cells_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_CellResampler_h
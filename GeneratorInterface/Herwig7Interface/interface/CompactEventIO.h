@@ -0,0 +1,119 @@
+#ifndef GeneratorInterface_Herwig7Interface_CompactEventIO_h
+#define GeneratorInterface_Herwig7Interface_CompactEventIO_h
+
+/** \class CompactEventIO
+ *
+ * @brief Compact binary event file with a random-access index, usable wherever HepMC::IO_GenEvent is
+ *
+ * Layout of a file:
+ *   header   "H7CE", version, flags, events per block        (4 x uint32)
+ *   blocks   raw size, compressed size, number of events     (3 x uint32)
+ *            followed by the zlib compressed event records
+ *   index    number of blocks and of events (2 x uint64), per block
+ *            its offset and the number of its first event (2 x uint64)
+ *   footer   offset of the index (uint64), "H7CI"
+ *
+ * In an event record all counts, ids and indices are varints (signed
+ * values zigzag encoded); vertices are referenced by their index in the
+ * event, 0 meaning none. Momenta, masses and positions are stored as
+ * doubles, or as floats if the file is written quantized; barcodes are
+ * stored as differences to the previous one. All blocks but the last one
+ * hold the same number of events, so the block of event N is found
+ * without a search. Files of killed jobs lack the index, it is then
+ * rebuilt by scanning the block headers.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <HepMC/GenEvent.h>
+#include <HepMC/IO_BaseClass.h>
+
+struct CompactEvent {
+	struct Particle {
+		int		barcode;
+		int		pdgId;
+		int		status;
+		double		px, py, pz, e, m;
+		unsigned int	productionVertex;	// index + 1, 0 for none
+		unsigned int	endVertex;		// index + 1, 0 for none
+	};
+
+	struct Vertex {
+		int		barcode;
+		double		x, y, z, t;
+	};
+
+	long				eventNumber;
+	int				signalProcessId;
+	unsigned int			signalVertex;	// index + 1, 0 for none
+	unsigned int			beam1, beam2;	// particle index + 1, 0 for none
+	std::vector<double>		weights;
+	std::vector<Vertex>		vertices;
+	std::vector<Particle>		particles;
+
+	void clear();
+
+	void fromHepMC(const HepMC::GenEvent &event);
+	void toHepMC(HepMC::GenEvent &event) const;
+};
+
+class CompactEventIO : public HepMC::IO_BaseClass {
+    public:
+	CompactEventIO(const std::string &fileName, std::ios::openmode mode,
+	               bool quantize = false, unsigned int eventsPerBlock = 100);
+	virtual ~CompactEventIO();
+
+	// HepMC::IO_BaseClass interface
+	virtual void write_event(const HepMC::GenEvent *event);
+	virtual bool fill_next_event(HepMC::GenEvent *event);
+	virtual void print(std::ostream &os = std::cout) const;
+
+	// Record level access, also used for records not built from a GenEvent
+	void write(const CompactEvent &event);
+	bool read(CompactEvent &event);
+
+	// Position the reader before event n, false if there is no such event
+	bool seek(uint64_t n);
+	uint64_t size() const { return nEvents_; }
+
+	// Write the pending block, the index and the footer
+	void close();
+
+    private:
+	struct IndexEntry {
+		uint64_t	offset;
+		uint64_t	firstEvent;
+	};
+
+	void flushBlock();
+	bool loadBlock(size_t block);
+	bool readIndex();
+	void scanBlocks();
+
+	void encode(const CompactEvent &event, std::string &out) const;
+	bool decode(CompactEvent &event);
+
+	std::fstream		file_;
+	const std::string	fileName_;
+	const bool		writing_;
+	bool			quantize_;
+	unsigned int		eventsPerBlock_;
+	bool			closed_;
+
+	std::vector<IndexEntry>	index_;
+	uint64_t		nEvents_;
+
+	// Uncompressed block being written or read
+	std::string		block_;
+	unsigned int		blockEvents_;
+	size_t			blockPos_;
+	size_t			currentBlock_;
+	unsigned int		eventInBlock_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_CompactEventIO_h
@@ -0,0 +1,67 @@
+#ifndef GeneratorInterface_Herwig7Interface_ContentHash_h
+#define GeneratorInterface_Herwig7Interface_ContentHash_h
+
+/** \class ContentHash
+ *
+ * @brief Incremental 64 bit FNV-1a hash used as key for on-disk caches
+ *
+ * The hash is stable across platforms and releases as long as the same
+ * bytes are fed in, which is all the caches of this interface require.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <stdint.h>
+
+class ContentHash {
+    public:
+	ContentHash() : hash_(14695981039346656037ULL) {}
+
+	ContentHash &update(const void *data, size_t size)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash_ ^= bytes[i];
+			hash_ *= 1099511628211ULL;
+		}
+		return *this;
+	}
+
+	ContentHash &update(const std::string &value)
+	{
+		// Include the length, so that concatenations of different strings differ
+		uint64_t size = value.size();
+		update(&size, sizeof(size));
+		return update(value.data(), value.size());
+	}
+
+	ContentHash &update(int64_t value) { return update(&value, sizeof(value)); }
+
+	// Hash the contents of a file, returns false if it cannot be read
+	bool updateFile(const std::string &fileName)
+	{
+		std::ifstream in(fileName.c_str(), std::ios::binary);
+		if (!in)
+			return false;
+		char buffer[65536];
+		while (in.read(buffer, sizeof(buffer)) || in.gcount())
+			update(buffer, in.gcount());
+		return true;
+	}
+
+	uint64_t value() const { return hash_; }
+
+	std::string hex() const
+	{
+		char buffer[17];
+		std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash_));
+		return buffer;
+	}
+
+    private:
+	uint64_t	hash_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_ContentHash_h
@@ -0,0 +1,54 @@
+#ifndef GeneratorInterface_Herwig7Interface_CpuPlacement_h
+#define GeneratorInterface_Herwig7Interface_CpuPlacement_h
+
+/** \class CpuPlacement
+ *
+ * @brief Pins a worker process to cores and to the memory of their NUMA node
+ *
+ * The CPUs the process may run on are ordered from the topology in /sys:
+ * per NUMA node the physical cores first and their hyperthreads after
+ * them. With the compact policy the nodes follow each other, so
+ * consecutive workers share a node until it is full; with the scatter
+ * policy the nodes alternate, so consecutive workers are spread over the
+ * sockets. Worker N gets the next cpusPerWorker CPUs of that order. If
+ * they all belong to one node, memory is preferably allocated there, so
+ * grids and event buffers created after the pinning are local. All threads
+ * of the process are pinned; the memory policy is set for the calling
+ * thread and is inherited by the threads it starts.
+ */
+
+#include <string>
+#include <vector>
+
+class CpuPlacement {
+    public:
+	enum Policy { None, Compact, Scatter };
+
+	static Policy policy(const std::string &name);
+
+	CpuPlacement(Policy policy);
+
+	// CPUs of a worker, empty without placement
+	std::vector<int> cpus(unsigned int worker, unsigned int cpusPerWorker) const;
+
+	// NUMA node of the CPUs, -1 if they span several nodes
+	int node(const std::vector<int> &cpus) const;
+
+	// Pin all threads of the process, false if the kernel refused it
+	bool pin(unsigned int worker, unsigned int cpusPerWorker) const;
+
+    private:
+	struct Cpu {
+		int	id;
+		int	node;
+		int	core;
+		int	thread;
+	};
+
+	// Physical cores before their hyperthreads
+	static bool coresFirst(const Cpu &a, const Cpu &b);
+
+	std::vector<Cpu>	order_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_CpuPlacement_h
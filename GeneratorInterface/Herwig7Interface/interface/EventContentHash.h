@@ -0,0 +1,47 @@
+#ifndef GeneratorInterface_Herwig7Interface_EventContentHash_h
+#define GeneratorInterface_Herwig7Interface_EventContentHash_h
+
+/** \class EventContentHash
+ *
+ * @brief Order-stable 64 bit hash of the content of a HepMC event
+ *
+ * The particles are hashed in barcode order with their PDG id, status,
+ * momentum, mass and the barcodes of their production and end vertices,
+ * followed by the nominal weight. Floating point values are hashed in
+ * single precision, so events read back from a quantized compact file
+ * hash to the same value as the original ones. The event number is not
+ * part of the hash, which lets runs with different numbering or skipped
+ * events be compared. Per event one line "<number> <hash>" is written.
+ */
+
+#include <fstream>
+#include <string>
+
+#include <stdint.h>
+
+#include <HepMC/GenEvent.h>
+
+#include "GeneratorInterface/Herwig7Interface/interface/ContentHash.h"
+
+class EventContentHash {
+    public:
+	EventContentHash(const std::string &fileName);
+
+	static uint64_t hash(const HepMC::GenEvent &event);
+
+	// Hash the event, append it to the file and fold it into the hash of the job
+	uint64_t add(const HepMC::GenEvent &event);
+
+	unsigned long long events() const { return events_; }
+	uint64_t combined() const { return combined_.value(); }
+
+	// Parse one line of a hash file
+	static bool read(std::istream &in, long long &number, uint64_t &hash);
+
+    private:
+	std::ofstream		out_;
+	unsigned long long	events_;
+	ContentHash		combined_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_EventContentHash_h
@@ -0,0 +1,63 @@
+#ifndef GeneratorInterface_Herwig7Interface_FinalStateFilter_h
+#define GeneratorInterface_Herwig7Interface_FinalStateFilter_h
+
+/** \class FinalStateFilter
+ *
+ * @brief Selection on the final state of the ThePEG event, before conversion to HepMC
+ *
+ * A selection counts the final state particles with one of its PDG ids
+ * (charge conjugates included, any particle if none are given) above pT
+ * and within |eta| thresholds. An event passes if every selection finds
+ * at least its minimal number of particles. Like GenFilterInfo, the sums
+ * of the positive and negative weights of the tried and passed events
+ * give the filter efficiency, for the job and for the current luminosity
+ * block.
+ */
+
+#include <vector>
+
+#include <ThePEG/Config/ThePEG.h>
+#include <ThePEG/EventRecord/Event.h>
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+class FinalStateFilter {
+    public:
+	FinalStateFilter(const std::vector<edm::ParameterSet> &selections);
+
+	struct Counts {
+		Counts() { reset(); }
+		void reset();
+		void add(bool pass, double weight);
+		double efficiency() const;
+
+		unsigned long long	tried;
+		unsigned long long	passed;
+		double			sumPassPositive;
+		double			sumPassNegative;
+		double			sumTotalPositive;
+		double			sumTotalNegative;
+	};
+
+	bool pass(const ThePEG::EventPtr &event, double weight);
+
+	const Counts &job() const { return job_; }
+	const Counts &lumi() const { return lumi_; }
+	void resetLumi() { lumi_.reset(); }
+
+    private:
+	bool select(const ThePEG::EventPtr &event) const;
+
+	struct Selection {
+		std::vector<long>	pdgIds;
+		unsigned int		minCount;
+		double			ptMin;
+		double			etaMax;
+	};
+
+	std::vector<Selection>	selections_;
+	Counts			job_;
+	Counts			lumi_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_FinalStateFilter_h
@@ -0,0 +1,32 @@
+#ifndef GeneratorInterface_Herwig7Interface_Herwig7Analysis_h
+#define GeneratorInterface_Herwig7Interface_Herwig7Analysis_h
+
+/** \class Herwig7Analysis
+ *
+ * @brief Base class for analyses which consume the converted HepMC events in-process
+ *
+ * Analyses are loaded as edm plugins by name (parameter "type") and are
+ * handed every event produced by the hadronizer. Histograms should be
+ * written in endJob(), since no event files are written for them.
+ */
+
+#include <HepMC/GenEvent.h>
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/PluginManager/interface/PluginFactory.h"
+
+class Herwig7Analysis {
+    public:
+	Herwig7Analysis(const edm::ParameterSet &params) {}
+	virtual ~Herwig7Analysis() {}
+
+	virtual void analyze(const HepMC::GenEvent &event) = 0;
+	virtual void endJob() {}
+};
+
+typedef edmplugin::PluginFactory<Herwig7Analysis *(const edm::ParameterSet &)> Herwig7AnalysisFactory;
+
+#define DEFINE_HERWIG7_ANALYSIS(type) \
+	DEFINE_EDM_PLUGIN(Herwig7AnalysisFactory, type, #type)
+
+#endif // GeneratorInterface_Herwig7Interface_Herwig7Analysis_h
@@ -0,0 +1,59 @@
+#ifndef GeneratorInterface_Herwig7Interface_Herwig7AnalysisDispatcher_h
+#define GeneratorInterface_Herwig7Interface_Herwig7AnalysisDispatcher_h
+
+/** \class Herwig7AnalysisDispatcher
+ *
+ * @brief Hands the converted events to a set of Herwig7Analysis plugins
+ *
+ * Without worker threads the analyses are called directly. Otherwise the
+ * analyses are distributed over the worker threads, each of which owns a
+ * bounded queue of events, so every analysis sees the events in order and
+ * is never called concurrently. The producer blocks if a queue is full.
+ */
+
+#include <deque>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <HepMC/GenEvent.h>
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/Herwig7Analysis.h"
+
+class Herwig7AnalysisDispatcher {
+    public:
+	Herwig7AnalysisDispatcher(const std::vector<edm::ParameterSet> &analyses,
+	                          unsigned int threads, unsigned int queueSize);
+	~Herwig7AnalysisDispatcher();
+
+	void analyze(const HepMC::GenEvent &event);
+
+	// Drain the queues, stop the workers and call endJob() of all analyses
+	void finish();
+
+    private:
+	typedef boost::shared_ptr<const HepMC::GenEvent> EventPtr;
+
+	struct Worker {
+		Worker() : done(false) {}
+
+		std::vector<boost::shared_ptr<Herwig7Analysis> >	analyses;
+		std::deque<EventPtr>		queue;
+		boost::mutex			mutex;
+		boost::condition_variable	notEmpty;
+		boost::condition_variable	notFull;
+		bool				done;
+	};
+
+	void run(Worker *worker);
+
+	std::vector<boost::shared_ptr<Worker> >	workers_;
+	boost::thread_group			threads_;
+	const unsigned int			queueSize_;
+	bool					finished_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_Herwig7AnalysisDispatcher_h
@@ -10,6 +10,7 @@ Marco A. Harrendorf
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 
@@ -25,6 +26,11 @@ Marco A. Harrendorf
 #include "GeneratorInterface/Herwig7Interface/interface/RandomEngineGlue.h"
 #include "GeneratorInterface/Herwig7Interface/interface/HepMCTemplate.h"
 #include "GeneratorInterface/Herwig7Interface/interface/HerwigUIProvider.h"
+#include "GeneratorInterface/Herwig7Interface/interface/Herwig7AnalysisDispatcher.h"
+#include "GeneratorInterface/Herwig7Interface/interface/ThroughputMonitor.h"
+#include "GeneratorInterface/Herwig7Interface/interface/StartupPreloader.h"
+#include "GeneratorInterface/Herwig7Interface/interface/PhaseMemoryProfiler.h"
+#include "GeneratorInterface/Herwig7Interface/interface/RepositorySnapshots.h"
 
 namespace CLHEP {
   class HepRandomEngine;
@@ -46,6 +52,38 @@ class Herwig7Interface {
 	bool initGenerator();
 	void flushRandomNumberGenerator();
 
+	// CMSSW random engine of the current stream
+	CLHEP::HepRandomEngine *randomEngine() const { return randomEngineGlueProxy_->getRandomEngine(); }
+
+	// Persistent copy of the generator including the adapted sampler,
+	// loading applies the seed and run tag of this job like prepareRun
+	bool loadGeneratorState(const std::string &fileName);
+	void saveGeneratorState(const std::string &fileName) const;
+
+	// Ratio of the integrated to the maximal cross section of the sampler
+	double unweightingEfficiency() const;
+
+	// Attempts of the sampler so far and its maximal cross section in pb, false without a sampler
+	bool samplerStatistics(double &attempts, double &maxXSec) const;
+
+	// Generators of several processes sharing the job, the first one is generatorModule
+	struct Process {
+		std::string	generator;
+		std::string	run;
+		double		fraction;
+		ThePEG::EGPtr	eg;
+		unsigned long	events;
+		// Cross section in pb when the generator was prepared, and the event weight factor
+		// sigma / (fraction * sum of sigma) making the mixture a sample of all processes
+		double		xsec;
+		double		xsecErr;
+		double		weight;
+	};
+	std::vector<Process>	processes_;
+
+	// Make eg_ the generator of the next event, returns its process id
+	unsigned int selectProcess();
+
 	static std::auto_ptr<HepMC::GenEvent>
 				convert(const ThePEG::EventPtr &event);
 
@@ -55,6 +93,19 @@ class Herwig7Interface {
 
 	std::auto_ptr<HepMC::IO_BaseClass>	iobc_;
 
+	// In-process analyses fed with the converted events
+	std::auto_ptr<Herwig7AnalysisDispatcher>	analyses_;
+
+	// Periodic export of throughput metrics
+	std::auto_ptr<ThroughputMonitor>	metrics_;
+	void exportMetrics();
+
+	// Manifest of the files needed at startup, prefetched on later starts
+	std::auto_ptr<StartupPreloader>	preloader_;
+
+	// Opt-in memory accounting of the phases of the generation loop
+	std::auto_ptr<PhaseMemoryProfiler>	memoryProfiler_;
+
 	// HerwigUi contains settings piped to Herwig7
 	Herwig::HerwigUIProvider* HwUI_;
 
@@ -69,6 +120,14 @@ class Herwig7Interface {
 	// The Inputfile ist created according to the parameter set
 	void createInputFile(const edm::ParameterSet &params);
 
+	// Repeat the read or build step without the objects unreachable from the generator
+	void pruneRunFile(const edm::ParameterSet &params);
+
+	// Ship Herwig-scratch as one indexed archive and extract only the missing files
+	void packScratch(const std::string &archive);
+	void unpackScratch(const std::string &archive, const std::vector<std::string> &prefixes,
+	                   const std::vector<std::string> &excluded);
+
 
 
     private:
@@ -80,7 +139,17 @@ class Herwig7Interface {
 	const std::string			run_;
 	// File name containing Herwig input config 
 	std::string				dumpConfig_;
+	// Input file passed to Herwig, dumpConfig_ or only the commands after a snapshot
+	std::string				readInput_;
+	// Repository commands inserted before saverun by pruneRunFile
+	std::vector<std::string>		pruneCommands_;
 	const unsigned int			skipEvents_;
+	// Adapted sampler state shared by the run jobs
+	const std::string			samplerStateFile_;
+	const unsigned int			samplerWarmupEvents_;
+	// Directory of the repository snapshots taken after each command block
+	const std::string			snapshotDirectory_;
+	std::auto_ptr<RepositorySnapshots>	snapshots_;
 };
 
 
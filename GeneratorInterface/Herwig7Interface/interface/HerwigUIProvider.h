@@ -42,6 +42,9 @@ public:
   /// Repository name to operate on
   std::string repository() const { return repository_; }
 
+  /// Start the read step from another repository, e.g. a snapshot
+  void setRepository(const std::string &repository) { repository_ = repository; }
+
   /// Name of the setup file to be read, to modify the repository
   std::string setupfile() const { return setupfile_; }
  
@@ -60,6 +63,11 @@ public:
   unsigned int jobSize() const { return jobsize_; }
   unsigned int maxJobs() const { return maxjobs_; }  
 
+  /// Size the integration jobs automatically after the build step
+  bool autoJobSize() const { return autoJobSize_; }
+  /// Number of cores or batch slots the automatic job sizing balances over
+  unsigned int integrationSlots() const { return integrationSlots_; }
+
   void quitWithHelp() const;
 
   void quit() const;
@@ -105,6 +113,9 @@ private:
   unsigned int jobsize_;
   unsigned int maxjobs_;
 
+  bool autoJobSize_;
+  unsigned int integrationSlots_;
+
 };
 
 }
@@ -0,0 +1,46 @@
+#ifndef GeneratorInterface_Herwig7Interface_IntegrationJobPlanner_h
+#define GeneratorInterface_Herwig7Interface_IntegrationJobPlanner_h
+
+/** \class IntegrationJobPlanner
+ *
+ * @brief Balances the integration jobs written by the build step over the available slots
+ *
+ * In the automatic job sizing mode the build step writes one integration
+ * job per subprocess bin. The planner estimates the cost of every bin from
+ * the runtimes recorded by earlier integrate steps (bins without a record
+ * get the mean cost, or unit cost if nothing is known yet) and merges the
+ * bins into as many jobs as there are slots, using the longest-processing-
+ * time-first heuristic. The predicted runtime of every job is kept next to
+ * the job lists, so the integrate step can report it with the actual one.
+ * No pilot integration is run, so the first build of a process only
+ * balances the number of bins per job.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+class IntegrationJobPlanner {
+    public:
+	IntegrationJobPlanner(const std::string &buildDirectory);
+
+	// Repartition the integration jobs into at most slots jobs
+	bool rebalance(unsigned int slots);
+
+	// Record the runtime of a finished integration job, returns the predicted one or -1
+	double recordRuntime(const std::string &integrationList, double seconds);
+
+	static unsigned int availableSlots();
+
+    private:
+	typedef std::vector<int> BinList;
+
+	bool readJobs(std::map<std::string, BinList> &jobs) const;
+	std::map<int, double> readCosts() const;
+
+	std::string jobFile(const std::string &name) const;
+
+	const std::string	buildDirectory_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_IntegrationJobPlanner_h
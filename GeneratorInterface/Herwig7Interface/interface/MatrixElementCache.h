@@ -0,0 +1,45 @@
+#ifndef GeneratorInterface_Herwig7Interface_MatrixElementCache_h
+#define GeneratorInterface_Herwig7Interface_MatrixElementCache_h
+
+/** \class MatrixElementCache
+ *
+ * @brief Content-addressed store for the external matrix element libraries of the build step
+ *
+ * The code generated and compiled by the Matchbox providers (e.g.
+ * MadGraph5_aMC@NLO) ends up in directories below Herwig-scratch. After a
+ * build these directories are copied to cacheDirectory/<key>, where the key
+ * is a hash of the Herwig input config (process definition and model) and
+ * of the compiler environment. On a hit the cached directories are copied
+ * into Herwig-scratch before the build, so the providers find their
+ * libraries and skip code generation and compilation. The entries are
+ * never linked, since the build may write to these directories.
+ */
+
+#include <string>
+#include <vector>
+
+class MatrixElementCache {
+    public:
+	MatrixElementCache(const std::string &cacheDirectory,
+	                   const std::string &scratchDirectory,
+	                   const std::vector<std::string> &libraryDirectories);
+
+	// Key from the Herwig input config file and the compiler environment
+	std::string key(const std::string &inputFile) const;
+
+	// Copy cached libraries into the scratch directory, true on a hit
+	bool restore(const std::string &key) const;
+
+	// Copy freshly built libraries into the cache
+	void store(const std::string &key) const;
+
+	// Let the generated makefiles compile with this number of parallel jobs
+	static void setCompileJobs(unsigned int jobs);
+
+    private:
+	const std::string		cacheDirectory_;
+	const std::string		scratchDirectory_;
+	const std::vector<std::string>	libraryDirectories_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_MatrixElementCache_h
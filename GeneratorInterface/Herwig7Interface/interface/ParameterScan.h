@@ -0,0 +1,64 @@
+#ifndef GeneratorInterface_Herwig7Interface_ParameterScan_h
+#define GeneratorInterface_Herwig7Interface_ParameterScan_h
+
+/** \class ParameterScan
+ *
+ * @brief Steps the live generator through a list of parameter points
+ *
+ * Every point is a list of "set object:interface value" commands. When a
+ * point is applied, the changed objects and every object referring to
+ * them, directly or through others (found with getReferences over all
+ * objects of the generator), are reset and initialized again, referenced
+ * objects first. Values derived in doinit or doinitrun, e.g. widths of a
+ * BSM model after a mass change, are so recomputed; the sampler adapts to
+ * the new cross section and starts its statistics anew, without
+ * repeating the read step and prepareRun. The events and the cross
+ * section of each point are recorded by the caller at the end of the
+ * luminosity block of the point.
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <ThePEG/Config/ThePEG.h>
+#include <ThePEG/Repository/EventGenerator.h>
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+class ParameterScan {
+    public:
+	ParameterScan(const std::vector<edm::ParameterSet> &points);
+
+	size_t points() const { return points_.size(); }
+
+	// Apply the next point, false once all are done
+	bool next(const ThePEG::EGPtr &eg);
+
+	void event() { if (current_ < points_.size()) ++points_[current_].events; }
+
+	// Record and log the cross section of the current point
+	void record(double xsec, double xsecErr);
+
+	void summary() const;
+
+    private:
+	struct Point {
+		std::string			name;
+		std::vector<std::string>	commands;
+		unsigned long			events;
+		double				xsec;
+		double				xsecErr;
+	};
+
+	void apply(const ThePEG::EGPtr &eg, const Point &point);
+
+	// Depth first over the references within affected, referenced objects come first
+	static void initOrder(const ThePEG::IBPtr &object, const std::set<ThePEG::IBPtr> &affected,
+	                      std::set<ThePEG::IBPtr> &visited, std::vector<ThePEG::IBPtr> &order);
+
+	std::vector<Point>	points_;
+	size_t			current_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_ParameterScan_h
@@ -0,0 +1,40 @@
+#ifndef GeneratorInterface_Herwig7Interface_PartialUnweighter_h
+#define GeneratorInterface_Herwig7Interface_PartialUnweighter_h
+
+/** \class PartialUnweighter
+ *
+ * @brief Unweights events with small weights before they reach the simulation
+ *
+ * Events with |w| below the threshold w_t are kept with probability
+ * |w| / w_t and get the weight sign(w) * w_t, events above the threshold
+ * are kept unchanged. This leaves all expectation values unchanged while
+ * near-zero weight events are mostly dropped. The threshold is either
+ * fixed or follows the largest |w| seen so far divided by the allowed
+ * weight spread, so the kept events satisfy max|w| / min|w| <= spread.
+ */
+
+class PartialUnweighter {
+    public:
+	// A positive minWeight fixes the threshold, otherwise maxSpread is used
+	PartialUnweighter(double minWeight, double maxSpread);
+
+	// Decide on an event, weight is replaced by the new weight if it is kept
+	bool accept(double &weight, double random);
+
+	unsigned long long attempted() const { return attempted_; }
+	unsigned long long kept() const { return kept_; }
+	double threshold() const;
+
+	// Fraction of the downstream simulation saved by the dropped events
+	double simulationSavings() const
+	{ return attempted_ ? 1. - double(kept_) / attempted_ : 0.; }
+
+    private:
+	const double		minWeight_;
+	const double		maxSpread_;
+	double			maxWeight_;
+	unsigned long long	attempted_;
+	unsigned long long	kept_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_PartialUnweighter_h
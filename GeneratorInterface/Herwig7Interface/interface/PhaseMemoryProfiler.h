@@ -0,0 +1,92 @@
+#ifndef GeneratorInterface_Herwig7Interface_PhaseMemoryProfiler_h
+#define GeneratorInterface_Herwig7Interface_PhaseMemoryProfiler_h
+
+/** \class PhaseMemoryProfiler
+ *
+ * @brief Live heap and RSS accounting of the phases of the generation loop
+ *
+ * Each phase (shoot, convert, dump, ...) is bracketed by a Scope, which
+ * takes the live heap of malloc and the RSS before and after. Changes
+ * between two scopes are booked to an "outside" phase, so the net changes
+ * of all phases add up to the growth of the job. Per phase the calls, the
+ * mean and largest live heap change and the mean RSS change are kept, and
+ * the net change is summed in windows of events.
+ *
+ * The job grows if the lowest live heap at the end of an event keeps rising
+ * from window to window; the phases which retain memory in most windows are
+ * then flagged. Memory allocated in one phase and freed in another (the
+ * event record freed by the framework between events) shows up as a pair
+ * of opposite changes. Counting individual allocations would need malloc
+ * hooks, which glibc no longer provides, so all numbers are net values.
+ * The live heap (mallinfo2, or mallinfo before glibc 2.33) and the RSS
+ * are figures of the whole process: with several streams the phases of
+ * one stream also see the allocations of the others.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+class PhaseMemoryProfiler {
+    public:
+	PhaseMemoryProfiler(unsigned int window, double growthThreshold);
+
+	// Accounts the enclosing block to a phase, does nothing without a profiler
+	class Scope {
+	    public:
+		Scope(PhaseMemoryProfiler *profiler, const char *phase);
+		~Scope();
+
+	    private:
+		Scope(const Scope &);
+		Scope &operator = (const Scope &);
+
+		PhaseMemoryProfiler	*profiler_;
+		size_t			phase_;
+		long			heap_;
+		long			rss_;
+	};
+
+	// Close the current event, logging its phases in debug mode
+	void endEvent();
+
+	// Ranked summary of all phases, flagging the growing ones
+	void summary() const;
+
+	// Bytes allocated by malloc and not yet freed
+	static long liveHeap();
+
+    private:
+	struct Phase {
+		std::string	name;
+		unsigned long	calls;
+		double		heapDelta;
+		long		maxHeapDelta;
+		double		rssDelta;
+		long		eventHeapDelta;
+		long		windowHeapDelta;
+		unsigned int	windows;
+		unsigned int	retainingWindows;
+	};
+
+	size_t phase(const char *name);
+	void enter(long heap, long rss);
+	void account(size_t phase, long heapDelta, long rssDelta);
+	bool jobGrowing() const;
+
+	const unsigned int		window_;
+	const long			growthThreshold_;
+	unsigned long			events_;
+	std::vector<Phase>		phases_;
+	std::map<std::string, size_t>	phaseIndex_;
+
+	// Heap and RSS at the end of the last scope, -1 before the first one
+	long				lastHeap_;
+	long				lastRss_;
+
+	// Lowest live heap at the end of an event, per window
+	long				windowMin_;
+	std::vector<long>		windowMins_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_PhaseMemoryProfiler_h
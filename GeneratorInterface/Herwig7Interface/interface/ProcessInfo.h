@@ -0,0 +1,29 @@
+#ifndef GeneratorInterface_Herwig7Interface_ProcessInfo_h
+#define GeneratorInterface_Herwig7Interface_ProcessInfo_h
+
+/**
+ * @brief Cheap queries of the resource usage of the current process
+ */
+
+#include <cstdio>
+
+#include <unistd.h>
+
+namespace ProcessInfo {
+
+	// Resident set size in bytes, 0 if it cannot be determined
+	inline long residentSetSize()
+	{
+		long pages = 0;
+		std::FILE *statm = std::fopen("/proc/self/statm", "r");
+		if (!statm)
+			return 0;
+		if (std::fscanf(statm, "%*s %ld", &pages) != 1)
+			pages = 0;
+		std::fclose(statm);
+		return pages * sysconf(_SC_PAGESIZE);
+	}
+
+}
+
+#endif // GeneratorInterface_Herwig7Interface_ProcessInfo_h
@@ -0,0 +1,91 @@
+#ifndef GeneratorInterface_Herwig7Interface_Rehadronizer_h
+#define GeneratorInterface_Herwig7Interface_Rehadronizer_h
+
+/** \class Rehadronizer
+ *
+ * @brief Hadronizes one showered event several times with varied tune parameters
+ *
+ * The hadronization and decay handlers are taken out of the event handler
+ * of the initialized generator, so shoot() stops after the parton shower
+ * and MPI. Each showered event is copied once per variation; the tune
+ * parameters of the variation are set on the live objects, the copy is
+ * hadronized and decayed and the parameters are set back. The event
+ * itself is hadronized last with the nominal parameters. Variations are
+ * lists of "set object:interface value" commands for parameters and
+ * switches, which are read at run time.
+ *
+ * A variation draws from its own random generator, seeded from the job
+ * seed, the event number and the variation, so the random stream of the
+ * generator and with it the nominal events are the same as without
+ * variations.
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <HepMC/GenEvent.h>
+#include <HepMC/IO_BaseClass.h>
+
+#include <ThePEG/Config/ThePEG.h>
+#include <ThePEG/Repository/EventGenerator.h>
+#include <ThePEG/EventRecord/Event.h>
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+namespace ThePEG {
+	class InterfaceBase;
+}
+
+class Rehadronizer {
+    public:
+	Rehadronizer(const std::vector<edm::ParameterSet> &variations);
+
+	// Take over the handlers of the generator and resolve the tune parameters
+	void init(const ThePEG::EGPtr &eg, long jobSeed);
+
+	// Generator whose events are varied
+	const ThePEG::EGPtr &generator() const { return eg_; }
+
+	size_t variations() const { return variations_.size(); }
+	const std::string &name(size_t variation) const { return variations_[variation].name; }
+
+	// Hadronize and decay an event with the parameters of a variation, or the nominal ones
+	bool hadronize(const ThePEG::EventPtr &event, size_t variation, long eventNumber);
+	bool hadronize(const ThePEG::EventPtr &event);
+
+	void write(size_t variation, const HepMC::GenEvent &event);
+
+	unsigned long failures(size_t variation) const { return variations_[variation].failures; }
+
+    private:
+	struct Setting {
+		std::string			objectName;
+		std::string			interfaceName;
+		ThePEG::IBPtr			object;
+		const ThePEG::InterfaceBase	*interface;
+		std::string			value;
+		std::string			nominal;
+	};
+
+	struct Variation {
+		std::string				name;
+		std::vector<Setting>			settings;
+		boost::shared_ptr<HepMC::IO_BaseClass>	output;
+		unsigned long				failures;
+	};
+
+	ThePEG::StepHdlPtr handler(const std::string &interface);
+	void apply(std::vector<Setting> &settings, bool nominal);
+	bool performSteps(const ThePEG::EventPtr &event, const ThePEG::RanGenPtr &random);
+
+	ThePEG::EGPtr			eg_;
+	ThePEG::RanGenPtr		random_;
+	long				jobSeed_;
+	ThePEG::StepHdlPtr		hadronizationHandler_;
+	ThePEG::StepHdlPtr		decayHandler_;
+	std::vector<Variation>		variations_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_Rehadronizer_h
@@ -0,0 +1,65 @@
+#ifndef GeneratorInterface_Herwig7Interface_RepositorySnapshots_h
+#define GeneratorInterface_Herwig7Interface_RepositorySnapshots_h
+
+/** \class RepositorySnapshots
+ *
+ * @brief Snapshots of the repository after each block of the Herwig input config
+ *
+ * The input config is split into blocks (config files, parameter sets,
+ * biasing, pruning). After each block the repository is saved to
+ * directory/<key>.rpo, where the key is a hash of the start repository
+ * and of all blocks up to and including this one. When the config is
+ * read again, the read step starts from the snapshot of the longest
+ * prefix of blocks that did not change and only replays the remaining
+ * ones. The snapshots are saved under temporary names and only become
+ * visible to other jobs after the step has succeeded.
+ *
+ * Files read by a block are looked up in the read directories and enter
+ * the key with their contents, following nested reads. The directory
+ * stack of the repository (cd, pushd, popd) is tracked through them and
+ * set again after a restored snapshot. A block reading a file that cannot
+ * be found, or loading a repository, ends the prefix that is snapshotted.
+ */
+
+#include <string>
+#include <vector>
+
+class RepositorySnapshots {
+    public:
+	RepositorySnapshots(const std::string &directory, const std::string &repository,
+	                    const std::vector<std::string> &readDirectories);
+	~RepositorySnapshots();
+
+	void addBlock(const std::string &commands);
+
+	const std::string &baseRepository() const { return repository_; }
+
+	// Repository to start from, the snapshot of the longest stored prefix
+	const std::string &repository() const { return start_; }
+
+	// Commands of the blocks after the stored prefix, each followed by the save of its snapshot
+	std::string input();
+
+	size_t blocks() const { return blocks_.size(); }
+	size_t snapshotBlocks() const { return keys_.size(); }
+	size_t restoredBlocks() const { return restored_; }
+
+	// Make the snapshots of a successful step visible under their keys
+	size_t commit();
+
+    private:
+	std::string path(size_t block) const;
+
+	const std::string		directory_;
+	const std::string		repository_;
+	const std::vector<std::string>	readDirectories_;
+	std::string			start_;
+	size_t				restored_;
+	std::vector<std::string>	blocks_;
+	std::vector<std::string>	keys_;
+	// Directory stack after each snapshotted block, a snapshot does not keep it
+	std::vector<std::vector<std::string> >	dirs_;
+	std::vector<std::string>	pending_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_RepositorySnapshots_h
@@ -0,0 +1,45 @@
+#ifndef GeneratorInterface_Herwig7Interface_RunFilePruner_h
+#define GeneratorInterface_Herwig7Interface_RunFilePruner_h
+
+/** \class RunFilePruner
+ *
+ * @brief Finds objects in a run file which cannot be reached from its generator
+ *
+ * The run file is loaded and the references of all interfaces are followed
+ * starting from the EventGenerator. Objects stored in the file but not
+ * reached this way are candidates for removal from the repository before
+ * the run file is saved again. Particles, decay modes and decayers are
+ * never removed, since the generator looks them up by PDG id at run time.
+ * All candidates go into one rm command: the repository removes them as a
+ * set, so candidates referring to each other do not block their removal.
+ */
+
+#include <string>
+#include <vector>
+
+class RunFilePruner {
+    public:
+	RunFilePruner(const std::string &runFile);
+
+	// Load the run file and compute the object sets, false on failure
+	bool analyse();
+
+	size_t storedObjects() const { return stored_; }
+	size_t reachableObjects() const { return reachable_; }
+	long fileSize() const;
+	// Change of the RSS caused by loading the run file, an estimate when the process has loaded it before
+	long loadedMemory() const { return loadedMemory_; }
+
+	size_t removableObjects() const { return removable_.size(); }
+	// Repository command removing all unreachable objects at once, empty if there are none
+	std::string removeCommand() const;
+
+    private:
+	const std::string		runFile_;
+	size_t				stored_;
+	size_t				reachable_;
+	long				loadedMemory_;
+	std::vector<std::string>	removable_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_RunFilePruner_h
@@ -0,0 +1,69 @@
+#ifndef GeneratorInterface_Herwig7Interface_ScratchArchive_h
+#define GeneratorInterface_Herwig7Interface_ScratchArchive_h
+
+/** \class ScratchArchive
+ *
+ * @brief Single-file indexed archive of the Herwig-scratch directory
+ *
+ * Layout of a file:
+ *   header   "H7SA", version                                    (2 x uint32)
+ *   data     contents of the files, symbolic links are packed as the
+ *            files they point to (archives of older versions may hold
+ *            link entries, which are extracted as links)
+ *   index    number of entries (uint64), per entry the length of the
+ *            path (uint32), the path relative to the packed directory,
+ *            type and mode (2 x uint32), offset and size (2 x uint64)
+ *   footer   offset of the index (uint64), "H7SI"
+ *
+ * The archive is read through a memory mapping, so opening it only touches
+ * the index. Entries are extracted on demand, selected by path prefixes,
+ * and only if they do not exist yet in the target directory.
+ */
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+class ScratchArchive {
+    public:
+	// Pack all files below a directory into a new archive, returns the number of entries
+	static size_t pack(const std::string &directory, const std::string &archive);
+
+	ScratchArchive(const std::string &archive);
+	~ScratchArchive();
+
+	bool valid() const { return data_ != 0; }
+	size_t entries() const { return entries_.size(); }
+
+	// Extract the missing entries below one of the prefixes but not below an excluded one
+	size_t extract(const std::string &directory, const std::vector<std::string> &prefixes,
+	               const std::vector<std::string> &excluded = std::vector<std::string>()) const;
+
+    private:
+	ScratchArchive(const ScratchArchive &);
+	ScratchArchive &operator = (const ScratchArchive &);
+
+	enum Type { File = 0, Link = 1 };
+
+	struct Entry {
+		std::string	path;
+		uint32_t	type;
+		uint32_t	mode;
+		uint64_t	offset;
+		uint64_t	size;
+
+		bool operator < (const Entry &other) const { return path < other.path; }
+	};
+
+	bool readIndex();
+	bool extract(const std::string &directory, const Entry &entry) const;
+
+	const std::string	archive_;
+	const char		*data_;
+	size_t			length_;
+	// Sorted by path, so the entries of a prefix are contiguous
+	std::vector<Entry>	entries_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_ScratchArchive_h
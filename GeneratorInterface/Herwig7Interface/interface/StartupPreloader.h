@@ -0,0 +1,58 @@
+#ifndef GeneratorInterface_Herwig7Interface_StartupPreloader_h
+#define GeneratorInterface_Herwig7Interface_StartupPreloader_h
+
+/** \class StartupPreloader
+ *
+ * @brief Records the files needed during initialization and prefetches them on later starts
+ *
+ * The shared objects and data files mapped by the process are snapshot
+ * when the interface is constructed and again after the generator has been
+ * initialized. The difference, together with the files Herwig reads
+ * explicitly (repository, input and run files), is written to a manifest,
+ * the libraries in the order of the dynamic linker's link map, i.e. in the
+ * order they were loaded. If the manifest exists at startup, all its files
+ * are read in parallel to warm the page cache, replacing the serial chain of
+ * opens on cold nodes with network filesystems. Once the library paths of
+ * the DynamicLoader are set, the libraries are preloaded with dlopen in the
+ * recorded order, so symbols resolve as in the recorded run.
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+class StartupPreloader {
+    public:
+	StartupPreloader(const std::string &manifest, unsigned int threads);
+
+	// Read all files listed in an existing manifest into the page cache
+	void prefetch();
+
+	// Load the libraries of the manifest in their recorded order, once
+	void preload();
+
+	// Add a file read by Herwig outside of the mapped files
+	void addFile(const std::string &fileName);
+
+	// Write the manifest from the files mapped since construction
+	void record();
+
+    private:
+	static std::set<std::string> mappedFiles();
+	static std::vector<std::string> loadedLibraries();
+	static void prefetchFiles(const std::vector<std::string> *files, size_t first, size_t step);
+	void readManifest();
+
+	const std::string		manifest_;
+	const unsigned int		threads_;
+	const std::set<std::string>	initialFiles_;
+	std::set<std::string>		extraFiles_;
+	bool				manifestRead_;
+	std::vector<std::string>	files_;
+	std::vector<std::string>	libraries_;
+	bool				preloaded_;
+	// Preloaded libraries stay loaded for the lifetime of the process, as ThePEG's ones do
+	std::vector<void *>		handles_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_StartupPreloader_h
@@ -0,0 +1,56 @@
+#ifndef GeneratorInterface_Herwig7Interface_ThroughputMonitor_h
+#define GeneratorInterface_Herwig7Interface_ThroughputMonitor_h
+
+/** \class ThroughputMonitor
+ *
+ * @brief Periodically exports throughput metrics of the generation in Prometheus text format
+ *
+ * The file is replaced atomically, so it can be scraped (e.g. by the
+ * textfile collector of the node exporter) at any time. Rates are given
+ * for the last interval, the ETA uses the rate averaged over the job.
+ * The time from the start of the event loop to the last event is
+ * exported separately, so benchmarks can leave out the initialization.
+ */
+
+#include <chrono>
+#include <string>
+
+class ThroughputMonitor {
+    public:
+	ThroughputMonitor(const std::string &fileName, double interval, unsigned long long expectedEvents);
+	~ThroughputMonitor();
+
+	void accepted() { ++accepted_; lastEvent_ = Clock::now(); }
+	void failed() { ++failed_; lastEvent_ = Clock::now(); }
+
+	// Start of the event loop, the first call counts; the duration of the loop
+	// excludes the initialization and is exported for benchmarks
+	void startGeneration();
+
+	// True if the next export is due, the caller then sets the values and calls write()
+	bool due() const;
+
+	void setCrossSection(double value, double error) { xsec_ = value; xsecErr_ = error; }
+
+	void write();
+
+    private:
+	typedef std::chrono::steady_clock Clock;
+
+	const std::string	fileName_;
+	const Clock::duration	interval_;
+	const unsigned long long	expectedEvents_;
+
+	Clock::time_point	start_;
+	Clock::time_point	last_;
+	bool			generating_;
+	Clock::time_point	generationStart_;
+	Clock::time_point	lastEvent_;
+	unsigned long long	accepted_;
+	unsigned long long	failed_;
+	unsigned long long	lastAccepted_;
+	double			xsec_;
+	double			xsecErr_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_ThroughputMonitor_h
@@ -0,0 +1,55 @@
+#ifndef GeneratorInterface_Herwig7Interface_XSecAccumulator_h
+#define GeneratorInterface_Herwig7Interface_XSecAccumulator_h
+
+/** \class XSecAccumulator
+ *
+ * @brief Incremental cross section estimate from event weights and sampler attempts
+ *
+ * Every generated event adds its weight times the maximal cross section
+ * of the sampler at the time it was generated, in pb, and the number of
+ * attempts the sampler needed for it. The sampler may raise its maximum
+ * during the run, so the conversion to pb happens per event. The mean
+ * per attempt is the cross section, its error follows from the variance
+ * over all attempts (rejected attempts contribute zero). Independent
+ * estimates, e.g. of several luminosity blocks, combine by adding their
+ * sums.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+class XSecAccumulator {
+    public:
+	XSecAccumulator() { reset(); }
+
+	void reset() { sumWeights_ = sumWeights2_ = attempts_ = 0.; events_ = 0; }
+
+	void add(double xsecWeight, double attempts)
+	{
+		sumWeights_ += xsecWeight;
+		sumWeights2_ += xsecWeight * xsecWeight;
+		attempts_ += attempts;
+		++events_;
+	}
+
+	unsigned long events() const { return events_; }
+	double attempts() const { return attempts_; }
+
+	// In pb
+	double xsec() const { return attempts_ > 0. ? sumWeights_ / attempts_ : 0.; }
+	double xsecErr() const
+	{
+		if (attempts_ <= 1.)
+			return 0.;
+		double mean = xsec();
+		return std::sqrt(std::max(0., sumWeights2_ / attempts_ - mean * mean) / (attempts_ - 1.));
+	}
+
+    private:
+	double		sumWeights_;
+	double		sumWeights2_;
+	double		attempts_;
+	unsigned long	events_;
+};
+
+#endif // GeneratorInterface_Herwig7Interface_XSecAccumulator_h
@@ -1,11 +1,20 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <map>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include <HepMC/GenEvent.h>
+
+#include <CLHEP/Random/RandomEngine.h>
 #include <HepMC/IO_BaseClass.h>
 
 #include <ThePEG/Repository/Repository.h>
 #include <ThePEG/EventRecord/Event.h>
+#include <ThePEG/EventRecord/Particle.h>
 #include <ThePEG/Config/ThePEG.h>
 #include <ThePEG/LesHouches/LesHouchesReader.h>
 
@@ -22,6 +31,14 @@
 #include "GeneratorInterface/LHEInterface/interface/LHEProxy.h"
 
 #include "GeneratorInterface/Herwig7Interface/interface/Herwig7Interface.h"
+#include "GeneratorInterface/Herwig7Interface/interface/CellResampler.h"
+#include "GeneratorInterface/Herwig7Interface/interface/PartialUnweighter.h"
+#include "GeneratorInterface/Herwig7Interface/interface/Rehadronizer.h"
+#include "GeneratorInterface/Herwig7Interface/interface/CompactEventIO.h"
+#include "GeneratorInterface/Herwig7Interface/interface/ParameterScan.h"
+#include "GeneratorInterface/Herwig7Interface/interface/FinalStateFilter.h"
+#include "GeneratorInterface/Herwig7Interface/interface/EventContentHash.h"
+#include "GeneratorInterface/Herwig7Interface/interface/XSecAccumulator.h"
 
 namespace CLHEP {
   class HepRandomEngine;
@@ -40,6 +57,9 @@ class Herwig7Hadronizer : public Herwig7Interface, public gen::BaseHadronizer {
 
 	void statistics();
 
+	// Job summary of the optional features, logged once at the end of the run
+	void summary();
+
 	bool generatePartonsAndHadronize();
 	bool hadronize();
 	bool decay();
@@ -52,9 +72,76 @@ class Herwig7Hadronizer : public Herwig7Interface, public gen::BaseHadronizer {
 
         virtual void doSetRandomEngine(CLHEP::HepRandomEngine* v) override { setPEGRandomEngine(v); }
 
+	// Shoot and convert one event into event()
+	bool generateEvent();
+
+	// Hand out the next event of the resampled buffer, refilling it if empty
+	bool nextResampledEvent();
+
+	// Hadronize the showered event with all tune variations, then with the nominal tune
+	bool rehadronize();
+
+	// Write a batch of final states to the minimum bias library, without EDM products
+	bool fillLibrary();
+
+	// Add the weight and sampler attempts of the event to the cross section estimates
+	void accumulateXSec(double weight);
+
+	// Set the nominal weight and scale all other weights by the same factor
+	static void setWeight(HepMC::GenEvent &event, double weight);
+
 	unsigned int			eventsToPrint;
 
 	ThePEG::EventPtr		thepegEvent;
+	double				pthat_;
+	unsigned int			processId_;
+
+	struct BufferedEvent {
+		HepMC::GenEvent		*event;
+		double			pthat;
+		unsigned int		processId;
+	};
+
+	std::auto_ptr<CellResampler>	cellResampler_;
+	unsigned int			resamplingBufferSize_;
+	std::deque<BufferedEvent>	resampledEvents_;
+
+	std::auto_ptr<PartialUnweighter>	unweighter_;
+
+	std::auto_ptr<Rehadronizer>	rehadronizer_;
+
+	std::auto_ptr<ParameterScan>	scan_;
+
+	// Selection before the conversion, rejected events are never converted
+	std::auto_ptr<FinalStateFilter>	preFilter_;
+	bool				preFilterRejected_;
+	double				configuredFilterEfficiency_;
+
+	// Biased generation, the bias factor is stored as second binning value
+	bool				biased_;
+	double				biasPower_;
+	double				biasScale_;
+	unsigned long			biasedEvents_;
+	double				sumWeights_;
+	double				sumWeights2_;
+	double				minWeight_;
+	double				maxWeight_;
+
+	// Running cross section of the job and of the current luminosity block
+	XSecAccumulator			jobXSec_;
+	XSecAccumulator			lumiXSec_;
+	double				lastAttempts_;
+	// A luminosity block is open from initializeForInternalPartons until its statistics() call,
+	// a statistics() call without an open block is the one at the end of the run
+	bool				lumiOpen_;
+	bool				summaryDone_;
+
+	// Content hash of every converted event, for comparisons between runs
+	std::auto_ptr<EventContentHash>	hashes_;
+
+	std::auto_ptr<CompactEventIO>	library_;
+	unsigned int			libraryBatchSize_;
+	unsigned long			libraryEvents_;
 	
 	boost::shared_ptr<lhef::LHEProxy> proxy_;
 	const std::string		handlerDirectory_;
@@ -64,23 +151,144 @@ Herwig7Hadronizer::Herwig7Hadronizer(const edm::ParameterSet &pset) :
 	Herwig7Interface(pset),
 	BaseHadronizer(pset),
 	eventsToPrint(pset.getUntrackedParameter<unsigned int>("eventsToPrint", 0)),
+	pthat_(-1.0),
+	processId_(0),
+	resamplingBufferSize_(0),
+	preFilterRejected_(false),
+	configuredFilterEfficiency_(-1.),
+	biased_(false),
+	biasPower_(0.),
+	biasScale_(1.),
+	biasedEvents_(0),
+	sumWeights_(0.),
+	sumWeights2_(0.),
+	minWeight_(0.),
+	maxWeight_(0.),
+	lastAttempts_(0.),
+	lumiOpen_(false),
+	summaryDone_(false),
+	libraryBatchSize_(0),
+	libraryEvents_(0),
 	handlerDirectory_(pset.getParameter<std::string>("eventHandlers"))
 {  
 	initRepository(pset);
 
+	// Negative weight reduction for NLO samples
+	if (pset.exists("cellResampling")) {
+		edm::ParameterSet resampling = pset.getUntrackedParameter<edm::ParameterSet>("cellResampling");
+		resamplingBufferSize_ = resampling.getUntrackedParameter<unsigned int>("bufferSize", 1000);
+		cellResampler_.reset(new CellResampler(resampling.getUntrackedParameter<double>("maxCellRadius", -1.)));
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Cell resampling switched on for buffers of "
+							    << resamplingBufferSize_ << " events";
+	}
+
+	// Drop most low weight events before the detector simulation
+	if (pset.exists("partialUnweighting")) {
+		edm::ParameterSet unweighting = pset.getUntrackedParameter<edm::ParameterSet>("partialUnweighting");
+		unweighter_.reset(new PartialUnweighter(
+			unweighting.getUntrackedParameter<double>("minWeight", -1.),
+			unweighting.getUntrackedParameter<double>("maxWeightSpread", 100.)));
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Partial unweighting switched on";
+	}
+
+	// One parameter point per luminosity block on the same generator
+	std::vector<edm::ParameterSet> scanPoints = pset.getUntrackedParameter<std::vector<edm::ParameterSet> >("parameterScan", std::vector<edm::ParameterSet>());
+	if (!scanPoints.empty()) {
+		scan_.reset(new ParameterScan(scanPoints));
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Parameter scan over " << scanPoints.size() << " points switched on";
+	}
+
+	// Cheap selection on the ThePEG final state
+	std::vector<edm::ParameterSet> selections = pset.getUntrackedParameter<std::vector<edm::ParameterSet> >("preConversionFilter", std::vector<edm::ParameterSet>());
+	if (!selections.empty()) {
+		preFilter_.reset(new FinalStateFilter(selections));
+		configuredFilterEfficiency_ = runInfo().filterEfficiency();
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Pre-conversion filter with " << selections.size() << " selections switched on";
+	}
+
+	// Reproducibility checks without diffing event dumps
+	std::string hashFile = pset.getUntrackedParameter<std::string>("eventHashes", "");
+	if (!hashFile.empty()) {
+		hashes_.reset(new EventContentHash(hashFile));
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Event content hashes switched on (=> " << hashFile << ")";
+	}
+
+	// pthat biasing, the reweighter itself is installed by createInputFile
+	if (pset.exists("biasing")) {
+		edm::ParameterSet biasing = pset.getUntrackedParameter<edm::ParameterSet>("biasing");
+		biased_ = true;
+		if (biasing.getUntrackedParameter<std::string>("reweighter", "").empty()) {
+			biasPower_ = biasing.getUntrackedParameter<double>("power");
+			biasScale_ = biasing.getUntrackedParameter<double>("scale");
+		}
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Biased generation switched on";
+	}
+
+	// Pileup libraries: batches of final states straight into a compact file
+	if (pset.exists("minimumBiasLibrary")) {
+		edm::ParameterSet library = pset.getUntrackedParameter<edm::ParameterSet>("minimumBiasLibrary");
+		std::string fileName = library.getUntrackedParameter<std::string>("fileName");
+		libraryBatchSize_ = library.getUntrackedParameter<unsigned int>("batchSize", 1000);
+		library_.reset(new CompactEventIO(fileName, std::ios::out,
+			library.getUntrackedParameter<bool>("quantize", true),
+			library.getUntrackedParameter<unsigned int>("blockSize", 1000)));
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Minimum bias library mode switched on (=> " << fileName << ", "
+							    << libraryBatchSize_ << " events per framework event)";
+	}
+
+	// Tune variations hadronizing the same showered events
+	std::vector<edm::ParameterSet> variations = pset.getUntrackedParameter<std::vector<edm::ParameterSet> >("rehadronization", std::vector<edm::ParameterSet>());
+	if (!variations.empty()) {
+		rehadronizer_.reset(new Rehadronizer(variations));
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Re-hadronization switched on for " << variations.size() << " tune variations";
+	}
 }
 
 Herwig7Hadronizer::~Herwig7Hadronizer()
 {
+	// Jobs whose last statistics() call closed a luminosity block still get their summary
+	if (!summaryDone_) {
+		if (!processes_.empty())
+			eg_ = processes_[0].eg;
+		if (eg_)
+			summary();
+	}
+	for (size_t i = 0; i < resampledEvents_.size(); ++i)
+		delete resampledEvents_[i].event;
 }
 
 bool Herwig7Hadronizer::initializeForInternalPartons()
 {
+	double maxXSec;
+	lumiXSec_.reset();
+	lumiOpen_ = true;
+	if (preFilter_.get())
+		preFilter_->resetLumi();
+
+	// Later luminosity blocks of a scan continue on the initialized generator
+	if (scan_.get() && eg_) {
+		if (!scan_->next(eg_))
+			edm::LogWarning("Generator|Herwig7Hadronizer") << "All " << scan_->points() << " scan points done, staying at the last one";
+		// A new point starts the sampler statistics again
+		if (!samplerStatistics(lastAttempts_, maxXSec))
+			lastAttempts_ = 0.;
+		return true;
+	}
+
 	if (!initGenerator())
 	{
 		edm::LogInfo("Generator|Herwig7Hadronizer") << "No run step for Herwig chosen. Program will be aborted.";
 		exit(0);
 	}
+	if (rehadronizer_.get())
+		rehadronizer_->init(eg_, HwUI_->seed());
+	if (scan_.get())
+		scan_->next(eg_);
+	// Attempts of skipped and warm-up events are not counted
+	if (!samplerStatistics(lastAttempts_, maxXSec))
+		lastAttempts_ = 0.;
+	if (metrics_.get())
+		metrics_->startGeneration();
 	return true;
 }
 
@@ -97,41 +305,369 @@ bool Herwig7Hadronizer::declareStableParticles(const std::vector<int> &pdgIds)
 
 void Herwig7Hadronizer::statistics()
 {
+	// GeneratorFilter calls this at the end of every luminosity block and once more at the end of the run
+	bool endOfRun = !lumiOpen_;
+	lumiOpen_ = false;
+
+	// The run summary refers to the generatorModule, the other processes are logged
+	if (!processes_.empty())
+		eg_ = processes_[0].eg;
+	if (endOfRun)
+		summary();
+
+	// The measured efficiency of the block, or of the job at the end of the run
+	if (preFilter_.get()) {
+		const FinalStateFilter::Counts &counts = endOfRun ? preFilter_->job() : preFilter_->lumi();
+		runInfo().setFilterEfficiency(counts.efficiency() *
+			(configuredFilterEfficiency_ > 0. ? configuredFilterEfficiency_ : 1.));
+	}
+
+	// The event weights carry sigma_i / fraction_i, the sample is normalized to the sum of the
+	// cross sections the weights were computed with
+	if (!processes_.empty()) {
+		double xsec = 0., xsecErr2 = 0.;
+		for (size_t i = 0; i < processes_.size(); ++i) {
+			xsec += processes_[i].xsec;
+			xsecErr2 += processes_[i].xsecErr * processes_[i].xsecErr;
+		}
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Sum of the cross sections of the " << processes_.size() << " processes "
+							    << xsec << " +- " << std::sqrt(xsecErr2) << " pb";
+		runInfo().setInternalXSec(GenRunInfoProduct::XSec(xsec, std::sqrt(xsecErr2)));
+		return;
+	}
+
+	// The points of a scan have no common cross section, only their luminosity blocks get one
+	if (scan_.get() && endOfRun) {
+		runInfo().setInternalXSec(GenRunInfoProduct::XSec());
+		return;
+	}
+
+	// GeneratorFilter copies the internal cross section into the GenLumiInfoProduct of each luminosity block
+	if (jobXSec_.attempts() > 0.) {
+		const XSecAccumulator &xsec = endOfRun ? jobXSec_ : lumiXSec_;
+		edm::LogInfo("Generator|Herwig7Hadronizer") << (endOfRun ? "Job" : "Luminosity block") << " cross section "
+							    << xsec.xsec() << " +- " << xsec.xsecErr() << " pb from "
+							    << xsec.events() << " events in " << xsec.attempts() << " attempts, generator total "
+							    << eg_->integratedXSec() / ThePEG::picobarn << " +- "
+							    << eg_->integratedXSecErr() / ThePEG::picobarn << " pb";
+		// One luminosity block per scan point
+		if (scan_.get())
+			scan_->record(lumiXSec_.xsec(), lumiXSec_.xsecErr());
+		runInfo().setInternalXSec(GenRunInfoProduct::XSec(xsec.xsec(), xsec.xsecErr()));
+		return;
+	}
+	// The sampler statistics start anew with every scan point
+	if (scan_.get())
+		scan_->record(eg_->integratedXSec() / ThePEG::picobarn, eg_->integratedXSecErr() / ThePEG::picobarn);
 	runInfo().setInternalXSec(GenRunInfoProduct::XSec(
 		eg_->integratedXSec() / ThePEG::picobarn,
 		eg_->integratedXSecErr() / ThePEG::picobarn));
 }
 
+void Herwig7Hadronizer::summary()
+{
+	summaryDone_ = true;
+	edm::LogInfo("Generator|Herwig7Hadronizer") << "Unweighting efficiency of this job: " << unweightingEfficiency();
+	if (cellResampler_.get() && cellResampler_->effectiveSizeBefore() > 0.)
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Cell resampling: " << cellResampler_->cells() << " cells, effective sample size "
+							    << cellResampler_->effectiveSizeBefore() << " -> " << cellResampler_->effectiveSizeAfter()
+							    << ", gain " << cellResampler_->effectiveSizeAfter() / cellResampler_->effectiveSizeBefore();
+	if (unweighter_.get())
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Partial unweighting: " << unweighter_->kept() << " of " << unweighter_->attempted()
+							    << " events kept, final weight threshold " << unweighter_->threshold()
+							    << ", expected simulation savings " << 100. * unweighter_->simulationSavings() << "%";
+	if (library_.get())
+		edm::LogInfo("Generator|Herwig7Hadronizer") << libraryEvents_ << " events written to the minimum bias library";
+	for (size_t i = 0; rehadronizer_.get() && i < rehadronizer_->variations(); ++i)
+		if (rehadronizer_->failures(i))
+			edm::LogWarning("Generator|Herwig7Hadronizer") << "Tune variation " << rehadronizer_->name(i) << ": hadronization failed in "
+								       << rehadronizer_->failures(i) << " events, which are missing in its output";
+	if (preFilter_.get()) {
+		const FinalStateFilter::Counts &counts = preFilter_->job();
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Pre-conversion filter: " << counts.passed << " of "
+							    << counts.tried << " events passed, weighted efficiency "
+							    << counts.efficiency();
+	}
+	if (hashes_.get())
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Content hashes of " << hashes_->events() << " events written, hash of the sequence "
+							    << std::hex << hashes_->combined() << std::dec;
+	if (scan_.get())
+		scan_->summary();
+	if (biased_ && sumWeights2_ > 0.)
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Biased generation: " << biasedEvents_ << " events, weights "
+							    << minWeight_ << " to " << maxWeight_ << ", mean " << sumWeights_ / biasedEvents_
+							    << ", effective number of events " << sumWeights_ * sumWeights_ / sumWeights2_;
+	for (size_t i = 0; i < processes_.size(); ++i)
+		edm::LogInfo("Generator|Herwig7Hadronizer") << "Process " << i << " (" << processes_[i].generator << "): "
+							    << processes_[i].events << " events, cross section "
+							    << processes_[i].eg->integratedXSec() / ThePEG::picobarn << " +- "
+							    << processes_[i].eg->integratedXSecErr() / ThePEG::picobarn << " pb at the end, "
+							    << processes_[i].xsec << " pb in the event weights";
+}
+
+void Herwig7Hadronizer::accumulateXSec(double weight)
+{
+	// The mixture of several generators has no common sampler
+	double attempts, maxXSec;
+	if (!processes_.empty() || !samplerStatistics(attempts, maxXSec))
+		return;
+	double delta = attempts >= lastAttempts_ ? attempts - lastAttempts_ : attempts;
+	lastAttempts_ = attempts;
+	// The sampler may have raised its maximum since the last event
+	jobXSec_.add(weight * maxXSec, delta);
+	lumiXSec_.add(weight * maxXSec, delta);
+}
+
 bool Herwig7Hadronizer::generatePartonsAndHadronize()
 {
-	edm::LogInfo("Generator|Herwig7Hadronizer") << "Start production";
+	if (library_.get())
+		return fillLibrary();
+
+	while (true) {
+		bool generated = cellResampler_.get() ? nextResampledEvent() : generateEvent();
+		if (!generated || !unweighter_.get())
+			return generated;
+
+		double weight = event()->weights().size() ? event()->weights()[0] : 1.;
+		if (unweighter_->accept(weight, randomEngine()->flat())) {
+			setWeight(*event(), weight);
+			return true;
+		}
+		event().reset();
+	}
+}
+
+void Herwig7Hadronizer::setWeight(HepMC::GenEvent &event, double weight)
+{
+	HepMC::WeightContainer &weights = event.weights();
+	if (weights.size() == 0) {
+		weights.push_back(weight);
+		return;
+	}
+	double ratio = weights[0] != 0. ? weight / weights[0] : 0.;
+	for (size_t j = 0; j < weights.size(); ++j)
+		weights[j] *= ratio;
+}
+
+bool Herwig7Hadronizer::generateEvent()
+{
+	LogDebug("Generator|Herwig7Hadronizer") << "Start production";
+	preFilterRejected_ = false;
 
 	flushRandomNumberGenerator();
 
+	if (!processes_.empty())
+		processId_ = selectProcess();
+
         try {
+                PhaseMemoryProfiler::Scope scope(memoryProfiler_.get(), "shoot");
                 thepegEvent = eg_->shoot();
         } catch (std::exception& exc) {
                 edm::LogWarning("Generator|Herwig7Hadronizer") << "EGPtr::shoot() thrown an exception, event skipped: " << exc.what();
+                if (metrics_.get()) {
+                        metrics_->failed();
+                        exportMetrics();
+                }
                 return false;
         } catch (...) {
                 edm::LogWarning("Generator|Herwig7Hadronizer") << "EGPtr::shoot() thrown an unknown exception, event skipped";
+                if (metrics_.get()) {
+                        metrics_->failed();
+                        exportMetrics();
+                }
                 return false;
         }        
         
 	if (!thepegEvent) {
 		edm::LogWarning("Generator|Herwig7Hadronizer") << "thepegEvent not initialized";
+		if (metrics_.get()) {
+			metrics_->failed();
+			exportMetrics();
+		}
 		return false;
 	}
 
-	event() = convert(thepegEvent);
+	if (rehadronizer_.get() && !rehadronize()) {
+		if (metrics_.get()) {
+			metrics_->failed();
+			exportMetrics();
+		}
+		return false;
+	}
+
+	// Counted only once the event is complete, like an event failing inside shoot()
+	accumulateXSec(thepegEvent->weight());
+
+	if (metrics_.get()) {
+		metrics_->accepted();
+		exportMetrics();
+	}
+
+	preFilterRejected_ = preFilter_.get() &&
+		!preFilter_->pass(thepegEvent, thepegEvent->weight() * (processes_.empty() ? 1. : processes_[processId_].weight));
+	if (preFilterRejected_)
+		return false;
+
+	{
+		PhaseMemoryProfiler::Scope scope(memoryProfiler_.get(), "convert");
+		event() = convert(thepegEvent);
+	}
 	if (!event().get()) {
 		edm::LogWarning("Generator|Herwig7Hadronizer") << "genEvent not initialized";
 		return false;
 	}
+	pthat_ = pthat(thepegEvent);
+
+	if (!processes_.empty())
+		setWeight(*event(), (event()->weights().size() ? event()->weights()[0] : 1.) * processes_[processId_].weight);
 
 	return true;
 }
 
+bool Herwig7Hadronizer::nextResampledEvent()
+{
+	if (resampledEvents_.empty()) {
+		std::vector<CellResampler::Event> cells;
+		unsigned int failures = 0;
+		while (resampledEvents_.size() < resamplingBufferSize_) {
+			if (!generateEvent()) {
+				if (preFilterRejected_)
+					continue;
+				// Give up on a generator which does not produce events any more
+				if (++failures > resamplingBufferSize_)
+					break;
+				continue;
+			}
+
+			// Flavour classes and momenta of the outgoing hard particles
+			std::vector<CellResampler::Particle> particles;
+			if (thepegEvent->primaryCollision()) {
+				const ThePEG::PVector &outgoing = thepegEvent->primaryCollision()->primarySubProcess()->outgoing();
+				for (ThePEG::PVector::const_iterator it = outgoing.begin(); it != outgoing.end(); ++it) {
+					long id = std::abs((*it)->id());
+					CellResampler::Particle particle;
+					particle.type = (id <= 6 || id == 21) ? 0 : int(id);
+					particle.px = (*it)->momentum().x() / ThePEG::GeV;
+					particle.py = (*it)->momentum().y() / ThePEG::GeV;
+					particle.pz = (*it)->momentum().z() / ThePEG::GeV;
+					particles.push_back(particle);
+				}
+			}
+			double weight = event()->weights().size() ? event()->weights()[0] : 1.;
+			cells.push_back(CellResampler::makeEvent(particles, weight));
+
+			BufferedEvent buffered = { event().release(), pthat_, processId_ };
+			resampledEvents_.push_back(buffered);
+		}
+		if (resampledEvents_.empty())
+			return false;
+
+		cellResampler_->resample(cells);
+
+		for (size_t i = 0; i < resampledEvents_.size(); ++i)
+			setWeight(*resampledEvents_[i].event, cells[i].weight);
+	}
+
+	event().reset(resampledEvents_.front().event);
+	pthat_ = resampledEvents_.front().pthat;
+	processId_ = resampledEvents_.front().processId;
+	resampledEvents_.pop_front();
+	return true;
+}
+
+bool Herwig7Hadronizer::fillLibrary()
+{
+	CompactEvent record;
+	for (unsigned int i = 0; i < libraryBatchSize_; ++i) {
+		flushRandomNumberGenerator();
+		unsigned int processId = processes_.empty() ? 0 : selectProcess();
+		try {
+			thepegEvent = eg_->shoot();
+		} catch (std::exception& exc) {
+			edm::LogWarning("Generator|Herwig7Hadronizer") << "EGPtr::shoot() thrown an exception, event skipped: " << exc.what();
+			thepegEvent = ThePEG::EventPtr();
+		} catch (...) {
+			edm::LogWarning("Generator|Herwig7Hadronizer") << "EGPtr::shoot() thrown an unknown exception, event skipped";
+			thepegEvent = ThePEG::EventPtr();
+		}
+		if (!thepegEvent) {
+			if (metrics_.get())
+				metrics_->failed();
+			continue;
+		}
+
+		// Only the final state is kept, with the positions it was produced at:
+		// the signal vertex at the origin and one vertex per displaced decay
+		record.clear();
+		record.eventNumber = thepegEvent->number();
+		record.weights.push_back(thepegEvent->weight() * (processes_.empty() ? 1. : processes_[processId].weight));
+		CompactEvent::Vertex origin = { -1, 0., 0., 0., 0. };
+		record.vertices.push_back(origin);
+		record.signalVertex = 1;
+		std::map<std::vector<double>, unsigned int> vertexIndex;
+
+		ThePEG::tPVector finalState = thepegEvent->getFinalState();
+		for (ThePEG::tPVector::const_iterator it = finalState.begin(); it != finalState.end(); ++it) {
+			CompactEvent::Particle particle;
+			particle.barcode = record.particles.size() + 1;
+			particle.pdgId = (*it)->id();
+			particle.status = 1;
+			particle.px = (*it)->momentum().x() / ThePEG::GeV;
+			particle.py = (*it)->momentum().y() / ThePEG::GeV;
+			particle.pz = (*it)->momentum().z() / ThePEG::GeV;
+			particle.e = (*it)->momentum().e() / ThePEG::GeV;
+			particle.m = (*it)->mass() / ThePEG::GeV;
+			particle.productionVertex = 1;
+			particle.endVertex = 0;
+
+			const ThePEG::LorentzPoint &position = (*it)->labVertex();
+			std::vector<double> key(4);
+			key[0] = position.x() / ThePEG::mm;
+			key[1] = position.y() / ThePEG::mm;
+			key[2] = position.z() / ThePEG::mm;
+			key[3] = position.t() / ThePEG::mm;
+			if (key[0] != 0. || key[1] != 0. || key[2] != 0. || key[3] != 0.) {
+				std::map<std::vector<double>, unsigned int>::const_iterator found = vertexIndex.find(key);
+				if (found == vertexIndex.end()) {
+					CompactEvent::Vertex vertex = { -int(record.vertices.size() + 1), key[0], key[1], key[2], key[3] };
+					record.vertices.push_back(vertex);
+					found = vertexIndex.insert(std::make_pair(key, (unsigned int)record.vertices.size())).first;
+				}
+				particle.productionVertex = found->second;
+			}
+			record.particles.push_back(particle);
+		}
+		library_->write(record);
+		++libraryEvents_;
+
+		if (metrics_.get())
+			metrics_->accepted();
+	}
+	if (metrics_.get())
+		exportMetrics();
+
+	// No products, Herwig7LibrarySource turns the library into generator events
+	return false;
+}
+
+bool Herwig7Hadronizer::rehadronize()
+{
+	// Only the main process is varied, the generators of the other processes hadronize in shoot()
+	if (eg_ != rehadronizer_->generator())
+		return true;
+
+	for (size_t i = 0; i < rehadronizer_->variations(); ++i) {
+		ThePEG::EventPtr variation = thepegEvent->clone();
+		if (rehadronizer_->hadronize(variation, i, thepegEvent->number())) {
+			std::auto_ptr<HepMC::GenEvent> event = convert(variation);
+			if (event.get())
+				rehadronizer_->write(i, *event);
+		}
+	}
+
+	return rehadronizer_->hadronize(thepegEvent);
+}
+
 bool Herwig7Hadronizer::hadronize()
 {
 
@@ -141,19 +677,54 @@ bool Herwig7Hadronizer::hadronize()
 
 void Herwig7Hadronizer::finalizeEvent()
 {
-	eventInfo().reset(new GenEventInfoProduct(event().get()));
-	eventInfo()->setBinningValues(
-			std::vector<double>(1, pthat(thepegEvent)));
-
-	if (eventsToPrint) {
-		eventsToPrint--;
-		event()->print();
+	{
+		PhaseMemoryProfiler::Scope scope(memoryProfiler_.get(), "finalize");
+		eventInfo().reset(new GenEventInfoProduct(event().get()));
+		std::vector<double> binningValues(1, pthat_);
+		if (biased_) {
+			double weight = event()->weights().size() ? event()->weights()[0] : 1.;
+			// ReweightMinPT biases by (pthat/scale)^power, other reweighters by the inverse weight
+			binningValues.push_back(biasPower_ != 0. ? std::pow(pthat_ / biasScale_, biasPower_) :
+			                        weight != 0. ? 1. / weight : 0.);
+			if (!biasedEvents_++)
+				minWeight_ = maxWeight_ = weight;
+			minWeight_ = std::min(minWeight_, weight);
+			maxWeight_ = std::max(maxWeight_, weight);
+			sumWeights_ += weight;
+			sumWeights2_ += weight * weight;
+		}
+		eventInfo()->setBinningValues(binningValues);
+		if (!processes_.empty())
+			eventInfo()->setSignalProcessID(processId_);
+
+		if (eventsToPrint) {
+			eventsToPrint--;
+			event()->print();
+		}
 	}
 
-	if (iobc_.get())
+	if (iobc_.get()) {
+		PhaseMemoryProfiler::Scope scope(memoryProfiler_.get(), "dump");
 		iobc_->write_event(event().get());
+	}
+
+	if (hashes_.get()) {
+		uint64_t hash = hashes_->add(*event());
+		LogDebug("Generator|Herwig7Hadronizer") << "Event " << event()->event_number() << " content hash " << std::hex << hash;
+	}
+
+	if (scan_.get())
+		scan_->event();
+
+	if (analyses_.get()) {
+		PhaseMemoryProfiler::Scope scope(memoryProfiler_.get(), "analyses");
+		analyses_->analyze(*event());
+	}
+
+	if (memoryProfiler_.get())
+		memoryProfiler_->endEvent();
 
-	edm::LogInfo("Generator|Herwig7Hadronizer") << "Event produced";
+	LogDebug("Generator|Herwig7Hadronizer") << "Event produced";
 }
 
 bool Herwig7Hadronizer::decay()
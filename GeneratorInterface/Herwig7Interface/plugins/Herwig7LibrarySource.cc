@@ -0,0 +1,83 @@
+/** \class Herwig7LibrarySource
+ *
+ *  Reads a minimum bias library written by the minimumBiasLibrary mode of
+ *  Herwig7GeneratorFilter and puts every library event into its own EDM
+ *  event, as HepMCProduct (instance "unsmeared", like a generator) and
+ *  GenEventInfoProduct. The output is the generator step of a minimum bias
+ *  sample, which is simulated and then mixed as pileup like any other.
+ *  Jobs sharing one library start at different events with firstEvent.
+ */
+
+#include <memory>
+#include <string>
+
+#include <HepMC/GenEvent.h>
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/InputSourceMacros.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Sources/interface/ProducerSourceBase.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "SimDataFormats/GeneratorProducts/interface/HepMCProduct.h"
+#include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/CompactEventIO.h"
+
+class Herwig7LibrarySource : public edm::ProducerSourceBase {
+    public:
+	Herwig7LibrarySource(const edm::ParameterSet &pset, const edm::InputSourceDescription &desc);
+	virtual ~Herwig7LibrarySource();
+
+    private:
+	virtual bool setRunAndEventInfo(edm::EventID &id, edm::TimeValue_t &time, edm::EventAuxiliary::ExperimentType &type) override;
+	virtual void produce(edm::Event &event) override;
+
+	const std::string		fileName_;
+	std::auto_ptr<CompactEventIO>	library_;
+	CompactEvent			record_;
+	unsigned long			events_;
+};
+
+Herwig7LibrarySource::Herwig7LibrarySource(const edm::ParameterSet &pset, const edm::InputSourceDescription &desc) :
+	edm::ProducerSourceBase(pset, desc, false),
+	fileName_(pset.getUntrackedParameter<std::string>("fileName")),
+	events_(0)
+{
+	library_.reset(new CompactEventIO(fileName_, std::ios::in));
+	unsigned int firstEvent = pset.getUntrackedParameter<unsigned int>("firstEvent", 0);
+	if (firstEvent && !library_->seek(firstEvent))
+		throw cms::Exception("Herwig7LibrarySource") << "Library " << fileName_ << " has only " << library_->size()
+							     << " events, cannot start at " << firstEvent << std::endl;
+	edm::LogInfo("Herwig7LibrarySource") << "Reading " << library_->size() << " library events from " << fileName_
+					     << ", starting at " << firstEvent;
+
+	produces<edm::HepMCProduct>("unsmeared");
+	produces<GenEventInfoProduct>();
+}
+
+Herwig7LibrarySource::~Herwig7LibrarySource()
+{
+	edm::LogInfo("Herwig7LibrarySource") << events_ << " library events read from " << fileName_;
+}
+
+bool Herwig7LibrarySource::setRunAndEventInfo(edm::EventID &, edm::TimeValue_t &, edm::EventAuxiliary::ExperimentType &)
+{
+	// The framework numbers the events, the input ends with the library
+	return library_->read(record_);
+}
+
+void Herwig7LibrarySource::produce(edm::Event &event)
+{
+	HepMC::GenEvent *genEvent = new HepMC::GenEvent();
+	record_.toHepMC(*genEvent);
+	++events_;
+
+	std::auto_ptr<GenEventInfoProduct> info(new GenEventInfoProduct(genEvent));
+	std::auto_ptr<edm::HepMCProduct> product(new edm::HepMCProduct(genEvent));
+	event.put(product, "unsmeared");
+	event.put(info);
+}
+
+DEFINE_FWK_INPUT_SOURCE(Herwig7LibrarySource);
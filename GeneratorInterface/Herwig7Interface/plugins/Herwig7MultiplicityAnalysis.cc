@@ -0,0 +1,83 @@
+/** \class Herwig7MultiplicityAnalysis
+ *
+ *  Example of an in-process analysis: histogram of the number of stable
+ *  particles within pT and |eta| cuts per event, written as a text table
+ *  "<multiplicity> <sum of weights>" at the end of the job.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <HepMC/GenEvent.h>
+#include <HepMC/GenParticle.h>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/Herwig7Analysis.h"
+
+class Herwig7MultiplicityAnalysis : public Herwig7Analysis {
+    public:
+	Herwig7MultiplicityAnalysis(const edm::ParameterSet &params);
+
+	virtual void analyze(const HepMC::GenEvent &event) override;
+	virtual void endJob() override;
+
+    private:
+	const std::string	fileName_;
+	const double		ptMin_;
+	const double		etaMax_;
+	// Sum of weights per multiplicity, the last bin collects the overflow
+	std::vector<double>	histogram_;
+	double			sumWeights_;
+	double			sumMultiplicity_;
+	unsigned long		events_;
+};
+
+Herwig7MultiplicityAnalysis::Herwig7MultiplicityAnalysis(const edm::ParameterSet &params) :
+	Herwig7Analysis(params),
+	fileName_(params.getUntrackedParameter<std::string>("fileName", "multiplicity.txt")),
+	ptMin_(params.getUntrackedParameter<double>("ptMin", 0.)),
+	etaMax_(params.getUntrackedParameter<double>("etaMax", -1.)),
+	histogram_(params.getUntrackedParameter<unsigned int>("maxMultiplicity", 500) + 1, 0.),
+	sumWeights_(0.),
+	sumMultiplicity_(0.),
+	events_(0)
+{
+}
+
+void Herwig7MultiplicityAnalysis::analyze(const HepMC::GenEvent &event)
+{
+	unsigned int multiplicity = 0;
+	for (HepMC::GenEvent::particle_const_iterator it = event.particles_begin(); it != event.particles_end(); ++it) {
+		if ((*it)->status() != 1)
+			continue;
+		const HepMC::FourVector &p = (*it)->momentum();
+		if (p.perp() < ptMin_)
+			continue;
+		if (etaMax_ >= 0. && (p.perp() == 0. || std::fabs(p.eta()) > etaMax_))
+			continue;
+		++multiplicity;
+	}
+
+	double weight = event.weights().size() ? event.weights()[0] : 1.;
+	histogram_[std::min<size_t>(multiplicity, histogram_.size() - 1)] += weight;
+	sumWeights_ += weight;
+	sumMultiplicity_ += weight * multiplicity;
+	++events_;
+}
+
+void Herwig7MultiplicityAnalysis::endJob()
+{
+	std::ofstream out(fileName_.c_str(), std::ios::out | std::ios::trunc);
+	for (size_t i = 0; i < histogram_.size(); ++i)
+		if (histogram_[i] != 0.)
+			out << i << " " << histogram_[i] << "\n";
+	edm::LogInfo("Herwig7Interface") << "Multiplicity analysis: " << events_ << " events, mean multiplicity "
+					 << (sumWeights_ != 0. ? sumMultiplicity_ / sumWeights_ : 0.) << ", written to " << fileName_;
+}
+
+DEFINE_HERWIG7_ANALYSIS(Herwig7MultiplicityAnalysis);
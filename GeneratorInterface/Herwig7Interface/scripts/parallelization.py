@@ -27,6 +27,10 @@
 # --keepfiles : don't remove the created temporary cmsRun files
 # --l/--log: write the output of each shell command called in a
 #     seperate log file
+# --pin compact/scatter: pin every build, integrate and run job to its
+#     own cores and the memory of their NUMA node
+# --metrics: every run job writes its throughput metrics to a file named
+#     after its cmsRun file, with the extension .metrics
 
 # Comments in the cmsRun file in the process.generator part may confuse
 # this script. Check the temporary cmsRun files if errors occur.
@@ -91,6 +95,10 @@ def adjust_pset(cmsrunfilename, savefilename, par_list):
         gen_string = re.sub(r',\s*integrationList\s*=\s*cms.untracked.string\((.*?)\)', '', gen_string)
         gen_string = re.sub(r',\s*maxJobs\s*=\s*cms.untracked.uint32\((.*?)\)', '', gen_string)
         gen_string = re.sub(r',\s*seed\s*=\s*cms.untracked.int32\((.*?)\)', '', gen_string)
+        gen_string = re.sub(r',\s*cpuPlacement\s*=\s*cms.untracked.string\((.*?)\)', '', gen_string)
+        gen_string = re.sub(r',\s*workerIndex\s*=\s*cms.untracked.uint32\((.*?)\)', '', gen_string)
+        gen_string = re.sub(r',\s*cpusPerWorker\s*=\s*cms.untracked.uint32\((.*?)\)', '', gen_string)
+        gen_string = re.sub(r',\s*metricsFile\s*=\s*cms.untracked.string\((.*?)\)', '', gen_string)
 
 
     # write the savefile with all parameters given in par_list
@@ -104,6 +112,16 @@ def adjust_pset(cmsrunfilename, savefilename, par_list):
 
 
 
+def placement(index, cpus):
+    """Parameters pinning the job with the given index to cpus cores, if --pin is set"""
+    if args.pin == 'none':
+        return []
+    return ['cpuPlacement = cms.untracked.string(\'' + args.pin + '\')',
+            'workerIndex = cms.untracked.uint32(' + str(index) + ')',
+            'cpusPerWorker = cms.untracked.uint32(' + str(cpus) + ')']
+
+
+
 def cleanupandexit(filelist):
     """Delete the files in filelist and exit"""
     for filename in filelist:
@@ -128,6 +146,8 @@ parser.add_argument('--keepfiles', help='don\'t delete temporary files', action=
 parser.add_argument('--stoprun', help='stop after creating the cmsRun files for the run step', action='store_true')
 parser.add_argument('--resumerun', help='use existing \'temporary\' files for the run step', action='store_true')
 parser.add_argument('-l', '--log', help='write the output of each process in a separate log file', action='store_true')
+parser.add_argument('--pin', help='pin the jobs to cores and their NUMA node', choices=['none', 'compact', 'scatter'], default='none')
+parser.add_argument('--metrics', help='write the throughput metrics of every run job to a file', action='store_true')
 
 args = parser.parse_args()
 
@@ -155,6 +175,7 @@ if args.build != 0:
     parameters.append('jobs = cms.untracked.int32(' + str(args.build) + ')')
     if args.integrate != 0:
         parameters.append('maxJobs = cms.untracked.uint32(' + str(args.integrate) + ')')
+    parameters += placement(0, args.build)
 
     build_name = template_name + '_build.py'
     adjust_pset(args.cmsRunfile, build_name, parameters)
@@ -207,6 +228,7 @@ if args.integrate != 0:
         # Set up parameters
         parameters = ['runModeList = cms.untracked.string(\'integrate\')']
         parameters.append('integrationList = cms.untracked.string(\'' + str(i) + '\')')
+        parameters += placement(i, 1)
     
         integration_name = template_name + '_integrate_' + str(i) + '.py'
         adjust_pset(args.cmsRunfile, integration_name, parameters)
@@ -277,6 +299,9 @@ if args.run != 0:
             parameters = ['runModeList = cms.untracked.string(\'run\')']
             # Set different seeds
             parameters.append('seed = cms.untracked.int32(' + str(seed + i) + ')')
+            parameters += placement(i, 1)
+            if args.metrics:
+                parameters.append('metricsFile = cms.untracked.string(\'' + run_name[:-2] + 'metrics\')')
             adjust_pset(args.cmsRunfile, run_name, parameters)
 
         # Unless run will be stopped execute the jobs
@@ -0,0 +1,112 @@
+#! /usr/bin/python
+
+# This script measures the effect of pinning the parallel run jobs to
+# cores and NUMA nodes.
+# The run step of the given cmsRun file is started with
+# parallelization.py without placement and with every placement
+# policy. A first round without placement is discarded, it only warms
+# the page cache. Then all policies are run --repeat times, in an order
+# rotating from repetition to repetition, so no policy always runs
+# first or last. Every run job writes its metrics; the rate of a job is
+# its number of events over the duration of its event loop, so the
+# initialization (prepareRun) does not enter.
+
+# Possible options:
+# -r/--run : number of parallel run jobs (and cores used)
+# -p/--policies : placement policies compared to no placement
+# -n/--repeat : number of rounds per policy
+
+# The build and integrate steps have to be done before.
+
+
+import argparse
+import math
+import os
+import re
+import subprocess
+import sys
+
+
+
+def metric(filename, name):
+    """Value of a metric in a Prometheus text file, None if it is missing"""
+    if not os.path.isfile(filename):
+        return None
+    with open(filename, 'r') as readfile:
+        match = re.search(r'^' + name + r' (\S+)$', readfile.read(), re.MULTILINE)
+    return float(match.group(1)) if match else None
+
+
+
+def run_round(policy):
+    """Run all jobs with the given placement, events/s of the event loop per job"""
+    template_name = args.cmsRunfile.replace('.', '_')
+    metrics = [template_name + '_run_' + str(i) + '.metrics' for i in range(args.run)]
+    for filename in metrics:
+        if os.path.isfile(filename):
+            os.remove(filename)
+    subprocess.call([sys.executable, script, args.cmsRunfile, '--run', str(args.run), '--log', '--metrics', '--pin', policy])
+    rates = []
+    for filename in metrics:
+        events = metric(filename, 'herwig7_events_total')
+        seconds = metric(filename, 'herwig7_generation_seconds')
+        if events and seconds:
+            rates.append(events / seconds)
+        else:
+            print 'No event loop metrics in {0}, job skipped.'.format(filename)
+    return rates
+
+
+
+def mean_and_error(values):
+    """Mean and its standard error"""
+    mean = sum(values) / len(values)
+    if len(values) < 2:
+        return mean, 0.
+    variance = sum((value - mean) ** 2 for value in values) / (len(values) - 1)
+    return mean, math.sqrt(variance / len(values))
+
+
+
+parser = argparse.ArgumentParser()
+
+parser.add_argument('cmsRunfile', help='filename of the cmsRun configuration')
+parser.add_argument('-r', '--run', help='set the number of run jobs', type=int, choices=range(1,11), default=2)
+parser.add_argument('-p', '--policies', help='placement policies to compare', nargs='+', choices=['compact', 'scatter'], default=['compact', 'scatter'])
+parser.add_argument('-n', '--repeat', help='rounds per policy', type=int, default=3)
+
+args = parser.parse_args()
+
+script = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'parallelization.py')
+
+policies = ['none'] + args.policies
+
+print 'Warm-up round without placement, not counted'
+run_round('none')
+
+results = dict((policy, []) for policy in policies)
+for repetition in range(args.repeat):
+    shift = repetition % len(policies)
+    for policy in policies[shift:] + policies[:shift]:
+        print 'Round {0}: {1} jobs with placement \'{2}\''.format(repetition + 1, args.run, policy)
+        # Every job runs on one core
+        results[policy] += run_round(policy)
+
+if not results['none']:
+    print 'No results without placement, nothing to compare.'
+    sys.exit(1)
+
+print '------------------------------------------'
+print 'placement   jobs   events/s/core (event loop)'
+summary = {}
+for policy in policies:
+    if not results[policy]:
+        continue
+    summary[policy] = mean_and_error(results[policy])
+    print '{0:<10}  {1:>4}   {2:>10.3f} +- {3:.3f}'.format(policy, len(results[policy]), summary[policy][0], summary[policy][1])
+reference = summary['none']
+for policy in args.policies:
+    if policy in summary:
+        ratio = summary[policy][0] / reference[0]
+        error = ratio * math.sqrt((summary[policy][1] / summary[policy][0]) ** 2 + (reference[1] / reference[0]) ** 2)
+        print '{0}: {1:+.1f} +- {2:.1f}% events/s/core relative to no placement'.format(policy, 100. * (ratio - 1.), 100. * error)
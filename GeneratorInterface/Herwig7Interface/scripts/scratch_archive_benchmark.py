@@ -0,0 +1,106 @@
+#! /usr/bin/python
+
+# This script measures the startup of a run job with and without the
+# scratch archive.
+# The run step of the given cmsRun file is started for one event, once
+# on the complete Herwig-scratch directory and once on an empty one,
+# which the job fills from the archive. The rounds alternate, a first
+# round of each kind is discarded since it only warms the page cache.
+# Reported are the wall time of the job and the startup phases it logs
+# (extraction from the archive, prepareRun).
+
+# Possible options:
+# -a/--archive : scratch archive written by the build, integrate or
+#     pack step
+# -n/--repeat : number of rounds of each kind
+
+# The build and integrate steps have to be done before.
+
+
+import argparse
+import math
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+
+
+def run_job(archive):
+    """Wall time and logged startup phases of a run job generating one event"""
+    filename = args.cmsRunfile.replace('.py', '_startup.py')
+    shutil.copy(args.cmsRunfile, filename)
+    with open(filename, 'a') as cmsrunfile:
+        cmsrunfile.write('\nprocess.generator.runModeList = cms.untracked.string(\'run\')\n')
+        cmsrunfile.write('process.generator.scratchArchive = cms.untracked.string(\'{0}\')\n'.format(archive))
+        cmsrunfile.write('process.maxEvents.input = cms.untracked.int32(1)\n')
+    logname = filename.replace('.py', '.log')
+    start = time.time()
+    with open(logname, 'w') as logfile:
+        subprocess.call(['cmsRun', filename], stdout=logfile, stderr=subprocess.STDOUT)
+    seconds = time.time() - start
+    with open(logname, 'r') as logfile:
+        phases = re.findall(r'Startup phase ([^:]*):.*?(\S+) s$', logfile.read(), re.MULTILINE)
+    os.remove(filename)
+    os.remove(logname)
+    return seconds, dict((phase, float(value)) for phase, value in phases)
+
+
+
+def with_archive():
+    """Run job starting from an empty Herwig-scratch, the complete one is moved aside"""
+    os.rename('Herwig-scratch', 'Herwig-scratch.complete')
+    try:
+        return run_job(args.archive)
+    finally:
+        shutil.rmtree('Herwig-scratch', ignore_errors=True)
+        os.rename('Herwig-scratch.complete', 'Herwig-scratch')
+
+
+
+def mean_and_error(values):
+    """Mean and its standard error"""
+    mean = sum(values) / len(values)
+    if len(values) < 2:
+        return mean, 0.
+    variance = sum((value - mean) ** 2 for value in values) / (len(values) - 1)
+    return mean, math.sqrt(variance / len(values))
+
+
+
+parser = argparse.ArgumentParser()
+
+parser.add_argument('cmsRunfile', help='filename of the cmsRun configuration')
+parser.add_argument('-a', '--archive', help='scratch archive', required=True)
+parser.add_argument('-n', '--repeat', help='rounds of each kind', type=int, default=3)
+
+args = parser.parse_args()
+
+if not os.path.isdir('Herwig-scratch') or not os.path.isfile(args.archive):
+    print 'Herwig-scratch and {0} are needed, run the build and integrate steps first.'.format(args.archive)
+    sys.exit(1)
+
+print 'Warm-up rounds, not counted'
+run_job('')
+with_archive()
+
+results = {'directory': [], 'archive': []}
+phases = {}
+for repetition in range(args.repeat):
+    print 'Round {0}'.format(repetition + 1)
+    seconds, logged = run_job('')
+    results['directory'].append(seconds)
+    seconds, logged = with_archive()
+    results['archive'].append(seconds)
+    for phase, value in logged.items():
+        phases.setdefault(phase, []).append(value)
+
+print '------------------------------------------'
+print 'Herwig-scratch   job wall time for one event'
+for kind in ['directory', 'archive']:
+    print '{0:<15}  {1:>8.2f} +- {2:.2f} s'.format(kind, *mean_and_error(results[kind]))
+print 'Startup phases logged with the archive:'
+for phase in sorted(phases):
+    print '  {0:<25}  {1:>8.2f} +- {2:.2f} s'.format(phase, *mean_and_error(phases[phase]))
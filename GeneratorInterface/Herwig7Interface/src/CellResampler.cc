@@ -0,0 +1,108 @@
+/** \class CellResampler
+ *
+ *  Negative weight reduction by cell resampling
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "GeneratorInterface/Herwig7Interface/interface/CellResampler.h"
+
+using namespace std;
+
+namespace {
+	bool byTypeAndPt(const CellResampler::Particle &a, const CellResampler::Particle &b)
+	{
+		if (a.type != b.type)
+			return a.type < b.type;
+		return a.px * a.px + a.py * a.py > b.px * b.px + b.py * b.py;
+	}
+}
+
+CellResampler::CellResampler(double maxRadius) :
+	maxRadius_(maxRadius),
+	essBefore_(0.), essAfter_(0.),
+	cells_(0)
+{
+}
+
+CellResampler::Event CellResampler::makeEvent(vector<Particle> particles, double weight)
+{
+	sort(particles.begin(), particles.end(), byTypeAndPt);
+	Event event;
+	event.particles.swap(particles);
+	event.weight = weight;
+	return event;
+}
+
+double CellResampler::distance(const Event &a, const Event &b)
+{
+	if (a.particles.size() != b.particles.size())
+		return numeric_limits<double>::infinity();
+
+	double d = 0.;
+	for (size_t i = 0; i < a.particles.size(); ++i) {
+		const Particle &p = a.particles[i];
+		const Particle &q = b.particles[i];
+		if (p.type != q.type)
+			return numeric_limits<double>::infinity();
+		d += sqrt((p.px - q.px) * (p.px - q.px) +
+		          (p.py - q.py) * (p.py - q.py) +
+		          (p.pz - q.pz) * (p.pz - q.pz));
+	}
+	return d;
+}
+
+double CellResampler::effectiveSize(const vector<Event> &events)
+{
+	double sum = 0., sum2 = 0.;
+	for (size_t i = 0; i < events.size(); ++i) {
+		sum += events[i].weight;
+		sum2 += events[i].weight * events[i].weight;
+	}
+	return sum2 > 0. ? sum * sum / sum2 : 0.;
+}
+
+void CellResampler::resample(vector<Event> &events)
+{
+	essBefore_ += effectiveSize(events);
+
+	vector<pair<double, size_t> > neighbours;
+	neighbours.reserve(events.size());
+	for (size_t seed = 0; seed < events.size(); ++seed) {
+		// Earlier cells may have made the seed non-negative already
+		if (events[seed].weight >= 0.)
+			continue;
+
+		neighbours.clear();
+		for (size_t i = 0; i < events.size(); ++i) {
+			if (i == seed)
+				continue;
+			double d = distance(events[seed], events[i]);
+			if (d == numeric_limits<double>::infinity() || (maxRadius_ > 0. && d > maxRadius_))
+				continue;
+			neighbours.push_back(make_pair(d, i));
+		}
+		sort(neighbours.begin(), neighbours.end());
+
+		vector<size_t> cell(1, seed);
+		double sum = events[seed].weight;
+		double sumAbs = -events[seed].weight;
+		for (size_t i = 0; i < neighbours.size() && sum < 0.; ++i) {
+			const Event &neighbour = events[neighbours[i].second];
+			cell.push_back(neighbours[i].second);
+			sum += neighbour.weight;
+			sumAbs += fabs(neighbour.weight);
+		}
+		if (cell.size() == 1)
+			continue;
+
+		for (size_t i = 0; i < cell.size(); ++i)
+			events[cell[i]].weight = fabs(events[cell[i]].weight) * sum / sumAbs;
+		++cells_;
+	}
+
+	essAfter_ += effectiveSize(events);
+}
@@ -0,0 +1,495 @@
+/** \class CompactEventIO
+ *
+ *  Compact binary event files with random access
+ */
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+#include <zlib.h>
+
+#include <HepMC/GenParticle.h>
+#include <HepMC/GenVertex.h>
+#include <HepMC/SimpleVector.h>
+
+#include "GeneratorInterface/Herwig7Interface/interface/CompactEventIO.h"
+
+using namespace std;
+
+namespace {
+	const char fileMagic[4] = { 'H', '7', 'C', 'E' };
+	const char indexMagic[4] = { 'H', '7', 'C', 'I' };
+	const uint32_t formatVersion = 1;
+	const uint32_t quantizedFlag = 1;
+	const size_t headerSize = 4 * sizeof(uint32_t);
+	const size_t footerSize = sizeof(uint64_t) + sizeof(indexMagic);
+
+	inline uint64_t zigzag(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+	inline int64_t unzigzag(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+	inline void putVarint(string &out, uint64_t value)
+	{
+		while (value >= 0x80) {
+			out += char((value & 0x7f) | 0x80);
+			value >>= 7;
+		}
+		out += char(value);
+	}
+
+	inline uint64_t getVarint(const string &in, size_t &pos)
+	{
+		uint64_t value = 0;
+		for (unsigned int shift = 0; pos < in.size() && shift < 64; shift += 7) {
+			unsigned char byte = in[pos++];
+			value |= uint64_t(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+				return value;
+		}
+		throw runtime_error("CompactEventIO: corrupt varint");
+	}
+
+	inline void putReal(string &out, double value, bool quantize)
+	{
+		if (quantize) {
+			float f = value;
+			out.append(reinterpret_cast<const char *>(&f), sizeof(f));
+		} else {
+			out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+		}
+	}
+
+	inline double getReal(const string &in, size_t &pos, bool quantize)
+	{
+		size_t size = quantize ? sizeof(float) : sizeof(double);
+		if (pos + size > in.size())
+			throw runtime_error("CompactEventIO: truncated event record");
+		double value;
+		if (quantize) {
+			float f;
+			memcpy(&f, &in[pos], sizeof(f));
+			value = f;
+		} else {
+			memcpy(&value, &in[pos], sizeof(value));
+		}
+		pos += size;
+		return value;
+	}
+
+	template<typename T>
+	inline void writeRaw(fstream &file, T value) { file.write(reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+	template<typename T>
+	inline bool readRaw(fstream &file, T &value) { return bool(file.read(reinterpret_cast<char *>(&value), sizeof(value))); }
+}
+
+void CompactEvent::clear()
+{
+	eventNumber = 0;
+	signalProcessId = 0;
+	signalVertex = beam1 = beam2 = 0;
+	weights.clear();
+	vertices.clear();
+	particles.clear();
+}
+
+void CompactEvent::fromHepMC(const HepMC::GenEvent &event)
+{
+	clear();
+	eventNumber = event.event_number();
+	signalProcessId = event.signal_process_id();
+	for (size_t i = 0; i < event.weights().size(); ++i)
+		weights.push_back(event.weights()[i]);
+
+	map<const HepMC::GenVertex *, unsigned int> vertexIndex;
+	for (HepMC::GenEvent::vertex_const_iterator it = event.vertices_begin(); it != event.vertices_end(); ++it) {
+		Vertex vertex;
+		vertex.barcode = (*it)->barcode();
+		vertex.x = (*it)->position().x();
+		vertex.y = (*it)->position().y();
+		vertex.z = (*it)->position().z();
+		vertex.t = (*it)->position().t();
+		vertices.push_back(vertex);
+		vertexIndex[*it] = vertices.size();
+	}
+	if (event.signal_process_vertex())
+		signalVertex = vertexIndex[event.signal_process_vertex()];
+
+	pair<HepMC::GenParticle *, HepMC::GenParticle *> beams = event.beam_particles();
+	for (HepMC::GenEvent::particle_const_iterator it = event.particles_begin(); it != event.particles_end(); ++it) {
+		Particle particle;
+		particle.barcode = (*it)->barcode();
+		particle.pdgId = (*it)->pdg_id();
+		particle.status = (*it)->status();
+		particle.px = (*it)->momentum().px();
+		particle.py = (*it)->momentum().py();
+		particle.pz = (*it)->momentum().pz();
+		particle.e = (*it)->momentum().e();
+		particle.m = (*it)->generated_mass();
+		particle.productionVertex = (*it)->production_vertex() ? vertexIndex[(*it)->production_vertex()] : 0;
+		particle.endVertex = (*it)->end_vertex() ? vertexIndex[(*it)->end_vertex()] : 0;
+		particles.push_back(particle);
+		if (*it == beams.first)
+			beam1 = particles.size();
+		if (*it == beams.second)
+			beam2 = particles.size();
+	}
+}
+
+void CompactEvent::toHepMC(HepMC::GenEvent &event) const
+{
+#ifdef HEPMC_HAS_UNITS
+	event.use_units(HepMC::Units::GEV, HepMC::Units::MM);
+#endif
+	event.set_event_number(eventNumber);
+	event.set_signal_process_id(signalProcessId);
+	for (size_t i = 0; i < weights.size(); ++i)
+		event.weights().push_back(weights[i]);
+
+	vector<HepMC::GenVertex *> genVertices;
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const Vertex &v = vertices[i];
+		HepMC::GenVertex *vertex = new HepMC::GenVertex(HepMC::FourVector(v.x, v.y, v.z, v.t));
+		vertex->suggest_barcode(v.barcode);
+		event.add_vertex(vertex);
+		genVertices.push_back(vertex);
+	}
+	if (signalVertex)
+		event.set_signal_process_vertex(genVertices[signalVertex - 1]);
+
+	HepMC::GenParticle *beamParticles[2] = { 0, 0 };
+	for (size_t i = 0; i < particles.size(); ++i) {
+		const Particle &p = particles[i];
+		// HepMC only knows particles attached to a vertex
+		if (!p.productionVertex && !p.endVertex)
+			continue;
+		HepMC::GenParticle *particle = new HepMC::GenParticle(
+			HepMC::FourVector(p.px, p.py, p.pz, p.e), p.pdgId, p.status);
+		particle->set_generated_mass(p.m);
+		particle->suggest_barcode(p.barcode);
+		if (p.productionVertex)
+			genVertices[p.productionVertex - 1]->add_particle_out(particle);
+		if (p.endVertex)
+			genVertices[p.endVertex - 1]->add_particle_in(particle);
+		if (i + 1 == beam1)
+			beamParticles[0] = particle;
+		if (i + 1 == beam2)
+			beamParticles[1] = particle;
+	}
+	if (beamParticles[0] && beamParticles[1])
+		event.set_beam_particles(beamParticles[0], beamParticles[1]);
+}
+
+CompactEventIO::CompactEventIO(const string &fileName, ios::openmode mode,
+                               bool quantize, unsigned int eventsPerBlock) :
+	fileName_(fileName),
+	writing_(mode & ios::out),
+	quantize_(quantize),
+	eventsPerBlock_(eventsPerBlock ? eventsPerBlock : 1),
+	closed_(false),
+	nEvents_(0),
+	blockEvents_(0),
+	blockPos_(0),
+	currentBlock_(size_t(-1)),
+	eventInBlock_(0)
+{
+	if (writing_) {
+		file_.open(fileName.c_str(), ios::out | ios::binary | ios::trunc);
+		if (!file_)
+			throw runtime_error("CompactEventIO: cannot open " + fileName);
+		file_.write(fileMagic, sizeof(fileMagic));
+		writeRaw<uint32_t>(file_, formatVersion);
+		writeRaw<uint32_t>(file_, quantize_ ? quantizedFlag : 0);
+		writeRaw<uint32_t>(file_, eventsPerBlock_);
+		return;
+	}
+
+	file_.open(fileName.c_str(), ios::in | ios::binary);
+	char magic[4];
+	uint32_t version, flags, perBlock;
+	if (!file_.read(magic, sizeof(magic)) || memcmp(magic, fileMagic, sizeof(magic)) ||
+	    !readRaw(file_, version) || version != formatVersion ||
+	    !readRaw(file_, flags) || !readRaw(file_, perBlock))
+		throw runtime_error("CompactEventIO: " + fileName + " is not a compact event file");
+	quantize_ = flags & quantizedFlag;
+	eventsPerBlock_ = perBlock;
+	closed_ = true;
+	if (!readIndex())
+		scanBlocks();
+}
+
+CompactEventIO::~CompactEventIO()
+{
+	close();
+}
+
+bool CompactEventIO::readIndex()
+{
+	file_.seekg(0, ios::end);
+	uint64_t end = file_.tellg();
+	if (end < headerSize + footerSize)
+		return false;
+
+	uint64_t indexOffset;
+	char magic[4];
+	file_.seekg(end - footerSize);
+	if (!readRaw(file_, indexOffset) || !file_.read(magic, sizeof(magic)) ||
+	    memcmp(magic, indexMagic, sizeof(magic)) || indexOffset >= end)
+		return false;
+
+	uint64_t nBlocks;
+	file_.seekg(indexOffset);
+	if (!readRaw(file_, nBlocks) || !readRaw(file_, nEvents_))
+		return false;
+	index_.resize(nBlocks);
+	for (uint64_t i = 0; i < nBlocks; ++i)
+		if (!readRaw(file_, index_[i].offset) || !readRaw(file_, index_[i].firstEvent))
+			return false;
+	return true;
+}
+
+void CompactEventIO::scanBlocks()
+{
+	file_.clear();
+	file_.seekg(0, ios::end);
+	uint64_t end = file_.tellg();
+
+	index_.clear();
+	nEvents_ = 0;
+	uint64_t offset = headerSize;
+	while (true) {
+		file_.seekg(offset);
+		uint32_t rawSize, compressedSize, events;
+		if (!readRaw(file_, rawSize) || !readRaw(file_, compressedSize) || !readRaw(file_, events))
+			break;
+		// Stop at a block cut short by a killed job or at a partially written index
+		uint64_t next = offset + 3 * sizeof(uint32_t) + compressedSize;
+		if (!compressedSize || !events || events > eventsPerBlock_ || next > end)
+			break;
+		IndexEntry entry = { offset, nEvents_ };
+		index_.push_back(entry);
+		nEvents_ += events;
+		offset = next;
+	}
+	file_.clear();
+}
+
+void CompactEventIO::encode(const CompactEvent &event, string &out) const
+{
+	putVarint(out, zigzag(event.eventNumber));
+	putVarint(out, zigzag(event.signalProcessId));
+	putVarint(out, event.signalVertex);
+	putVarint(out, event.beam1);
+	putVarint(out, event.beam2);
+
+	putVarint(out, event.weights.size());
+	for (size_t i = 0; i < event.weights.size(); ++i)
+		putReal(out, event.weights[i], false);
+
+	int lastBarcode = 0;
+	putVarint(out, event.vertices.size());
+	for (size_t i = 0; i < event.vertices.size(); ++i) {
+		const CompactEvent::Vertex &v = event.vertices[i];
+		putVarint(out, zigzag(int64_t(v.barcode) - lastBarcode));
+		lastBarcode = v.barcode;
+		putReal(out, v.x, quantize_);
+		putReal(out, v.y, quantize_);
+		putReal(out, v.z, quantize_);
+		putReal(out, v.t, quantize_);
+	}
+
+	lastBarcode = 0;
+	putVarint(out, event.particles.size());
+	for (size_t i = 0; i < event.particles.size(); ++i) {
+		const CompactEvent::Particle &p = event.particles[i];
+		putVarint(out, zigzag(int64_t(p.barcode) - lastBarcode));
+		lastBarcode = p.barcode;
+		putVarint(out, zigzag(p.pdgId));
+		putVarint(out, zigzag(p.status));
+		putVarint(out, p.productionVertex);
+		putVarint(out, p.endVertex);
+		putReal(out, p.px, quantize_);
+		putReal(out, p.py, quantize_);
+		putReal(out, p.pz, quantize_);
+		putReal(out, p.e, quantize_);
+		putReal(out, p.m, quantize_);
+	}
+}
+
+bool CompactEventIO::decode(CompactEvent &event)
+{
+	event.clear();
+	size_t &pos = blockPos_;
+	event.eventNumber = unzigzag(getVarint(block_, pos));
+	event.signalProcessId = unzigzag(getVarint(block_, pos));
+	event.signalVertex = getVarint(block_, pos);
+	event.beam1 = getVarint(block_, pos);
+	event.beam2 = getVarint(block_, pos);
+
+	event.weights.resize(getVarint(block_, pos));
+	for (size_t i = 0; i < event.weights.size(); ++i)
+		event.weights[i] = getReal(block_, pos, false);
+
+	int64_t barcode = 0;
+	event.vertices.resize(getVarint(block_, pos));
+	for (size_t i = 0; i < event.vertices.size(); ++i) {
+		CompactEvent::Vertex &v = event.vertices[i];
+		barcode += unzigzag(getVarint(block_, pos));
+		v.barcode = barcode;
+		v.x = getReal(block_, pos, quantize_);
+		v.y = getReal(block_, pos, quantize_);
+		v.z = getReal(block_, pos, quantize_);
+		v.t = getReal(block_, pos, quantize_);
+	}
+
+	barcode = 0;
+	event.particles.resize(getVarint(block_, pos));
+	for (size_t i = 0; i < event.particles.size(); ++i) {
+		CompactEvent::Particle &p = event.particles[i];
+		barcode += unzigzag(getVarint(block_, pos));
+		p.barcode = barcode;
+		p.pdgId = unzigzag(getVarint(block_, pos));
+		p.status = unzigzag(getVarint(block_, pos));
+		p.productionVertex = getVarint(block_, pos);
+		p.endVertex = getVarint(block_, pos);
+		p.px = getReal(block_, pos, quantize_);
+		p.py = getReal(block_, pos, quantize_);
+		p.pz = getReal(block_, pos, quantize_);
+		p.e = getReal(block_, pos, quantize_);
+		p.m = getReal(block_, pos, quantize_);
+	}
+	return true;
+}
+
+void CompactEventIO::write(const CompactEvent &event)
+{
+	if (!writing_ || closed_)
+		throw runtime_error("CompactEventIO: " + fileName_ + " is not open for writing");
+	encode(event, block_);
+	++nEvents_;
+	if (++blockEvents_ == eventsPerBlock_)
+		flushBlock();
+}
+
+void CompactEventIO::flushBlock()
+{
+	if (!blockEvents_)
+		return;
+
+	uLongf compressedSize = compressBound(block_.size());
+	vector<Bytef> compressed(compressedSize);
+	if (compress2(&compressed[0], &compressedSize,
+	              reinterpret_cast<const Bytef *>(block_.data()), block_.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+		throw runtime_error("CompactEventIO: compression failed");
+
+	IndexEntry entry = { uint64_t(file_.tellp()), nEvents_ - blockEvents_ };
+	index_.push_back(entry);
+	writeRaw<uint32_t>(file_, block_.size());
+	writeRaw<uint32_t>(file_, compressedSize);
+	writeRaw<uint32_t>(file_, blockEvents_);
+	file_.write(reinterpret_cast<const char *>(&compressed[0]), compressedSize);
+
+	block_.clear();
+	blockEvents_ = 0;
+}
+
+void CompactEventIO::close()
+{
+	if (closed_)
+		return;
+	closed_ = true;
+
+	flushBlock();
+	uint64_t indexOffset = file_.tellp();
+	writeRaw<uint64_t>(file_, index_.size());
+	writeRaw<uint64_t>(file_, nEvents_);
+	for (size_t i = 0; i < index_.size(); ++i) {
+		writeRaw(file_, index_[i].offset);
+		writeRaw(file_, index_[i].firstEvent);
+	}
+	writeRaw(file_, indexOffset);
+	file_.write(indexMagic, sizeof(indexMagic));
+	file_.close();
+}
+
+bool CompactEventIO::loadBlock(size_t block)
+{
+	if (block >= index_.size())
+		return false;
+
+	file_.clear();
+	file_.seekg(index_[block].offset);
+	uint32_t rawSize, compressedSize, events;
+	if (!readRaw(file_, rawSize) || !readRaw(file_, compressedSize) || !readRaw(file_, events))
+		return false;
+	vector<Bytef> compressed(compressedSize);
+	if (!file_.read(reinterpret_cast<char *>(&compressed[0]), compressedSize))
+		return false;
+
+	block_.resize(rawSize);
+	uLongf size = rawSize;
+	if (uncompress(reinterpret_cast<Bytef *>(&block_[0]), &size, &compressed[0], compressedSize) != Z_OK || size != rawSize)
+		return false;
+
+	currentBlock_ = block;
+	blockEvents_ = events;
+	blockPos_ = 0;
+	eventInBlock_ = 0;
+	return true;
+}
+
+bool CompactEventIO::read(CompactEvent &event)
+{
+	if (writing_)
+		return false;
+	if (currentBlock_ == size_t(-1) || eventInBlock_ == blockEvents_)
+		if (!loadBlock(currentBlock_ + 1))
+			return false;
+	++eventInBlock_;
+	return decode(event);
+}
+
+bool CompactEventIO::seek(uint64_t n)
+{
+	if (writing_ || n >= nEvents_)
+		return false;
+
+	size_t block = n / eventsPerBlock_;
+	if (block >= index_.size() || index_[block].firstEvent > n)
+		block = index_.size() - 1;
+	if (block != currentBlock_ || eventInBlock_ > n - index_[block].firstEvent)
+		if (!loadBlock(block))
+			return false;
+
+	CompactEvent skipped;
+	while (index_[block].firstEvent + eventInBlock_ < n) {
+		++eventInBlock_;
+		decode(skipped);
+	}
+	return true;
+}
+
+void CompactEventIO::write_event(const HepMC::GenEvent *event)
+{
+	if (!event)
+		return;
+	CompactEvent record;
+	record.fromHepMC(*event);
+	write(record);
+}
+
+bool CompactEventIO::fill_next_event(HepMC::GenEvent *event)
+{
+	CompactEvent record;
+	if (!event || !read(record))
+		return false;
+	record.toHepMC(*event);
+	return true;
+}
+
+void CompactEventIO::print(ostream &os) const
+{
+	os << "CompactEventIO: " << fileName_ << (writing_ ? " (writing)" : " (reading)")
+	   << ", " << nEvents_ << " events in " << index_.size() << " blocks"
+	   << (quantize_ ? ", quantized" : "") << endl;
+}
@@ -0,0 +1,187 @@
+/** \class CpuPlacement
+ *
+ *  Placement of worker processes on cores and NUMA nodes
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include <boost/filesystem.hpp>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/CpuPlacement.h"
+
+using namespace std;
+
+namespace {
+	int readNumber(const string &fileName, int fallback)
+	{
+		ifstream in(fileName.c_str());
+		int value;
+		return in >> value ? value : fallback;
+	}
+
+	// Node of every CPU from the cpuN links below /sys/devices/system/node/nodeM
+	map<int, int> cpuNodes()
+	{
+		namespace fs = boost::filesystem;
+		map<int, int> nodes;
+		boost::system::error_code ec;
+		for (fs::directory_iterator node("/sys/devices/system/node", ec), end; !ec && node != end; node.increment(ec)) {
+			string name = node->path().filename().string();
+			if (name.compare(0, 4, "node") || name.find_first_not_of("0123456789", 4) != string::npos)
+				continue;
+			for (fs::directory_iterator cpu(node->path(), ec); !ec && cpu != end; cpu.increment(ec)) {
+				string cpuName = cpu->path().filename().string();
+				if (cpuName.compare(0, 3, "cpu") == 0 && cpuName.size() > 3 &&
+				    cpuName.find_first_not_of("0123456789", 3) == string::npos)
+					nodes[atoi(cpuName.c_str() + 3)] = atoi(name.c_str() + 4);
+			}
+		}
+		return nodes;
+	}
+}
+
+bool CpuPlacement::coresFirst(const Cpu &a, const Cpu &b)
+{
+	return a.thread != b.thread ? a.thread < b.thread : a.core < b.core;
+}
+
+CpuPlacement::Policy CpuPlacement::policy(const string &name)
+{
+	if (name.empty() || name == "none")
+		return None;
+	if (name == "compact")
+		return Compact;
+	if (name == "scatter")
+		return Scatter;
+	throw cms::Exception("Herwig7Interface") << "Unknown cpuPlacement " << name << ", use none, compact or scatter" << endl;
+}
+
+CpuPlacement::CpuPlacement(Policy policy)
+{
+	cpu_set_t allowed;
+	if (policy == None || sched_getaffinity(0, sizeof(allowed), &allowed))
+		return;
+
+	// Only the CPUs the batch system left to the job, with their place in the topology
+	map<int, int> nodes = cpuNodes();
+	map<int, vector<Cpu> > byNode;
+	map<pair<int, int>, int> threadsPerCore;
+	for (int id = 0; id < CPU_SETSIZE; ++id) {
+		if (!CPU_ISSET(id, &allowed))
+			continue;
+		ostringstream topology;
+		topology << "/sys/devices/system/cpu/cpu" << id << "/topology/";
+		int package = readNumber(topology.str() + "physical_package_id", 0);
+		Cpu cpu;
+		cpu.id = id;
+		cpu.node = nodes.count(id) ? nodes[id] : package;
+		// Cores are numbered per package
+		cpu.core = package * 100000 + readNumber(topology.str() + "core_id", id);
+		cpu.thread = threadsPerCore[make_pair(cpu.node, cpu.core)]++;
+		byNode[cpu.node].push_back(cpu);
+	}
+
+	vector<vector<Cpu> > perNode;
+	for (map<int, vector<Cpu> >::iterator it = byNode.begin(); it != byNode.end(); ++it) {
+		sort(it->second.begin(), it->second.end(), coresFirst);
+		perNode.push_back(it->second);
+	}
+
+	if (policy == Compact) {
+		for (size_t n = 0; n < perNode.size(); ++n)
+			order_.insert(order_.end(), perNode[n].begin(), perNode[n].end());
+	} else {
+		for (size_t i = 0; order_.size() < size_t(CPU_COUNT(&allowed)); ++i)
+			for (size_t n = 0; n < perNode.size(); ++n)
+				if (i < perNode[n].size())
+					order_.push_back(perNode[n][i]);
+	}
+}
+
+vector<int> CpuPlacement::cpus(unsigned int worker, unsigned int cpusPerWorker) const
+{
+	vector<int> result;
+	if (order_.empty())
+		return result;
+	cpusPerWorker = max(1u, min(cpusPerWorker, (unsigned int)order_.size()));
+	for (unsigned int i = 0; i < cpusPerWorker; ++i)
+		result.push_back(order_[(size_t(worker) * cpusPerWorker + i) % order_.size()].id);
+	return result;
+}
+
+int CpuPlacement::node(const vector<int> &cpus) const
+{
+	int result = -1;
+	for (vector<int>::const_iterator id = cpus.begin(); id != cpus.end(); ++id)
+		for (vector<Cpu>::const_iterator cpu = order_.begin(); cpu != order_.end(); ++cpu) {
+			if (cpu->id != *id)
+				continue;
+			if (result >= 0 && cpu->node != result)
+				return -1;
+			result = cpu->node;
+		}
+	return result;
+}
+
+bool CpuPlacement::pin(unsigned int worker, unsigned int cpusPerWorker) const
+{
+	vector<int> ids = cpus(worker, cpusPerWorker);
+	if (ids.empty())
+		return false;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	ostringstream list;
+	for (vector<int>::const_iterator id = ids.begin(); id != ids.end(); ++id) {
+		CPU_SET(*id, &set);
+		list << (id == ids.begin() ? "" : ",") << *id;
+	}
+	// The affinity is per thread: the framework and Herwig may have started
+	// threads already, threads started later inherit it from their creator
+	namespace fs = boost::filesystem;
+	boost::system::error_code ec;
+	unsigned int threads = 0;
+	for (fs::directory_iterator task("/proc/self/task", ec), end; !ec && task != end; task.increment(ec)) {
+		pid_t tid = atoi(task->path().filename().string().c_str());
+		// A thread may have ended in the meantime
+		if (sched_setaffinity(tid, sizeof(set), &set) && errno != ESRCH) {
+			edm::LogWarning("Herwig7Interface") << "Worker " << worker << " could not be pinned to CPUs " << list.str();
+			return false;
+		}
+		++threads;
+	}
+	if (ec || !threads) {
+		if (sched_setaffinity(0, sizeof(set), &set)) {
+			edm::LogWarning("Herwig7Interface") << "Worker " << worker << " could not be pinned to CPUs " << list.str();
+			return false;
+		}
+		threads = 1;
+	}
+	list << " (" << threads << " threads)";
+
+	// Applies to the calling thread and the threads it starts later only,
+	// first touch places most pages of the other threads locally anyway
+	int numaNode = node(ids);
+	bool local = false;
+	if (numaNode >= 0 && numaNode < int(8 * sizeof(unsigned long))) {
+		unsigned long mask = 1UL << numaNode;
+		local = syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, 8 * sizeof(mask)) == 0;
+	}
+	if (local)
+		list << ", memory preferred on NUMA node " << numaNode;
+	edm::LogInfo("Herwig7Interface") << "Worker " << worker << " pinned to CPUs " << list.str();
+	return true;
+}
@@ -0,0 +1,83 @@
+/** \class EventContentHash
+ *
+ *  Order-stable hash of the content of a HepMC event
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "GeneratorInterface/Herwig7Interface/interface/EventContentHash.h"
+
+using namespace std;
+
+namespace {
+	template<typename T>
+	inline void mix(ContentHash &hash, T value) { hash.update(&value, sizeof(value)); }
+
+	// Single precision, -0 and 0 hash the same
+	inline void mixReal(ContentHash &hash, double value)
+	{
+		float quantized = float(value);
+		mix(hash, quantized == 0.f ? 0.f : quantized);
+	}
+
+	inline int barcode(const HepMC::GenVertex *vertex) { return vertex ? vertex->barcode() : 0; }
+
+	inline bool byBarcode(const HepMC::GenParticle *a, const HepMC::GenParticle *b) { return a->barcode() < b->barcode(); }
+}
+
+EventContentHash::EventContentHash(const string &fileName) :
+	out_(fileName.c_str(), ios::out | ios::trunc),
+	events_(0)
+{
+	if (!out_)
+		throw runtime_error("EventContentHash: cannot write " + fileName);
+}
+
+uint64_t EventContentHash::hash(const HepMC::GenEvent &event)
+{
+	vector<const HepMC::GenParticle *> particles(event.particles_begin(), event.particles_end());
+	sort(particles.begin(), particles.end(), byBarcode);
+
+	ContentHash hash;
+	mix<int32_t>(hash, particles.size());
+	for (vector<const HepMC::GenParticle *>::const_iterator it = particles.begin(); it != particles.end(); ++it) {
+		const HepMC::GenParticle &p = **it;
+		mix<int32_t>(hash, p.barcode());
+		mix<int32_t>(hash, p.pdg_id());
+		mix<int32_t>(hash, p.status());
+		mixReal(hash, p.momentum().px());
+		mixReal(hash, p.momentum().py());
+		mixReal(hash, p.momentum().pz());
+		mixReal(hash, p.momentum().e());
+		mixReal(hash, p.generated_mass());
+		mix<int32_t>(hash, barcode(p.production_vertex()));
+		mix<int32_t>(hash, barcode(p.end_vertex()));
+	}
+	mixReal(hash, event.weights().size() ? event.weights()[0] : 1.);
+	return hash.value();
+}
+
+uint64_t EventContentHash::add(const HepMC::GenEvent &event)
+{
+	uint64_t value = hash(event);
+	mix(combined_, value);
+	++events_;
+
+	char line[48];
+	snprintf(line, sizeof(line), "%d %016llx\n", event.event_number(), (unsigned long long)value);
+	out_ << line;
+	return value;
+}
+
+bool EventContentHash::read(istream &in, long long &number, uint64_t &hash)
+{
+	string hex;
+	if (!(in >> number >> hex))
+		return false;
+	hash = strtoull(hex.c_str(), 0, 16);
+	return true;
+}
@@ -0,0 +1,82 @@
+/** \class FinalStateFilter
+ *
+ *  Final state selection on ThePEG events
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <ThePEG/EventRecord/Particle.h>
+
+#include "GeneratorInterface/Herwig7Interface/interface/FinalStateFilter.h"
+
+using namespace std;
+
+void FinalStateFilter::Counts::reset()
+{
+	tried = passed = 0;
+	sumPassPositive = sumPassNegative = sumTotalPositive = sumTotalNegative = 0.;
+}
+
+void FinalStateFilter::Counts::add(bool pass, double weight)
+{
+	++tried;
+	(weight < 0. ? sumTotalNegative : sumTotalPositive) += fabs(weight);
+	if (!pass)
+		return;
+	++passed;
+	(weight < 0. ? sumPassNegative : sumPassPositive) += fabs(weight);
+}
+
+double FinalStateFilter::Counts::efficiency() const
+{
+	// Net weights, as GenFilterInfo for weighted events
+	double total = sumTotalPositive - sumTotalNegative;
+	return total != 0. ? (sumPassPositive - sumPassNegative) / total : 1.;
+}
+
+FinalStateFilter::FinalStateFilter(const vector<edm::ParameterSet> &selections)
+{
+	for (vector<edm::ParameterSet>::const_iterator it = selections.begin(); it != selections.end(); ++it) {
+		Selection selection;
+		vector<int> pdgIds = it->getUntrackedParameter<vector<int> >("pdgIds", vector<int>());
+		for (size_t i = 0; i < pdgIds.size(); ++i)
+			selection.pdgIds.push_back(abs(pdgIds[i]));
+		selection.minCount = it->getUntrackedParameter<unsigned int>("minCount", 1);
+		selection.ptMin = it->getUntrackedParameter<double>("ptMin", 0.);
+		selection.etaMax = it->getUntrackedParameter<double>("etaMax", -1.);
+		selections_.push_back(selection);
+	}
+}
+
+bool FinalStateFilter::pass(const ThePEG::EventPtr &event, double weight)
+{
+	bool passed = select(event);
+	job_.add(passed, weight);
+	lumi_.add(passed, weight);
+	return passed;
+}
+
+bool FinalStateFilter::select(const ThePEG::EventPtr &event) const
+{
+	ThePEG::tPVector finalState = event->getFinalState();
+
+	for (vector<Selection>::const_iterator sel = selections_.begin(); sel != selections_.end(); ++sel) {
+		unsigned int count = 0;
+		for (ThePEG::tPVector::const_iterator it = finalState.begin(); it != finalState.end() && count < sel->minCount; ++it) {
+			if (!sel->pdgIds.empty() && find(sel->pdgIds.begin(), sel->pdgIds.end(), abs((*it)->id())) == sel->pdgIds.end())
+				continue;
+			const ThePEG::Lorentz5Momentum &p = (*it)->momentum();
+			if (p.perp() / ThePEG::GeV < sel->ptMin)
+				continue;
+			if (sel->etaMax >= 0. && (p.perp() == ThePEG::ZERO || fabs(p.eta()) > sel->etaMax))
+				continue;
+			++count;
+		}
+		if (count < sel->minCount)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,104 @@
+/** \class Herwig7AnalysisDispatcher
+ *
+ *  Fan-out of the converted events to the in-process analyses
+ */
+
+#include <algorithm>
+#include <string>
+
+#include <boost/bind.hpp>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/Herwig7AnalysisDispatcher.h"
+
+EDM_REGISTER_PLUGINFACTORY(Herwig7AnalysisFactory, "Herwig7AnalysisFactory");
+
+Herwig7AnalysisDispatcher::Herwig7AnalysisDispatcher(
+			const std::vector<edm::ParameterSet> &analyses,
+			unsigned int threads, unsigned int queueSize) :
+	queueSize_(queueSize ? queueSize : 1),
+	finished_(false)
+{
+	// Without threads everything runs in the calling thread through one worker
+	unsigned int nWorkers = std::max(1u, std::min<unsigned int>(threads, analyses.size()));
+	for (unsigned int i = 0; i < nWorkers; ++i)
+		workers_.push_back(boost::shared_ptr<Worker>(new Worker));
+
+	for (size_t i = 0; i < analyses.size(); ++i) {
+		std::string type = analyses[i].getUntrackedParameter<std::string>("type");
+		boost::shared_ptr<Herwig7Analysis> analysis(
+			Herwig7AnalysisFactory::get()->create(type, analyses[i]));
+		workers_[i % nWorkers]->analyses.push_back(analysis);
+		edm::LogInfo("Herwig7Interface") << "Analysis " << type << " loaded.";
+	}
+
+	if (threads)
+		for (size_t i = 0; i < workers_.size(); ++i)
+			threads_.create_thread(boost::bind(&Herwig7AnalysisDispatcher::run, this, workers_[i].get()));
+}
+
+Herwig7AnalysisDispatcher::~Herwig7AnalysisDispatcher()
+{
+	finish();
+}
+
+void Herwig7AnalysisDispatcher::analyze(const HepMC::GenEvent &event)
+{
+	if (threads_.size() == 0) {
+		for (size_t i = 0; i < workers_[0]->analyses.size(); ++i)
+			workers_[0]->analyses[i]->analyze(event);
+		return;
+	}
+
+	// The framework takes ownership of the event, so the workers get a copy
+	EventPtr copy(new HepMC::GenEvent(event));
+	for (size_t i = 0; i < workers_.size(); ++i) {
+		Worker &worker = *workers_[i];
+		boost::mutex::scoped_lock scoped_lock(worker.mutex);
+		while (worker.queue.size() >= queueSize_)
+			worker.notFull.wait(scoped_lock);
+		worker.queue.push_back(copy);
+		worker.notEmpty.notify_one();
+	}
+}
+
+void Herwig7AnalysisDispatcher::run(Worker *worker)
+{
+	while (true) {
+		EventPtr event;
+		{
+			boost::mutex::scoped_lock scoped_lock(worker->mutex);
+			while (worker->queue.empty() && !worker->done)
+				worker->notEmpty.wait(scoped_lock);
+			if (worker->queue.empty())
+				return;
+			event = worker->queue.front();
+			worker->queue.pop_front();
+			worker->notFull.notify_one();
+		}
+
+		for (size_t i = 0; i < worker->analyses.size(); ++i)
+			worker->analyses[i]->analyze(*event);
+	}
+}
+
+void Herwig7AnalysisDispatcher::finish()
+{
+	if (finished_)
+		return;
+	finished_ = true;
+
+	for (size_t i = 0; i < workers_.size(); ++i) {
+		boost::mutex::scoped_lock scoped_lock(workers_[i]->mutex);
+		workers_[i]->done = true;
+		workers_[i]->notEmpty.notify_one();
+	}
+	threads_.join_all();
+
+	for (size_t i = 0; i < workers_.size(); ++i)
+		for (size_t j = 0; j < workers_[i]->analyses.size(); ++j)
+			workers_[i]->analyses[j]->endJob();
+
+	edm::LogInfo("Herwig7Interface") << "All analyses finished.";
+}
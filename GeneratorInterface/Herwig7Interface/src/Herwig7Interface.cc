@@ -13,6 +13,7 @@
 #include <stdlib.h>
 
 #include <algorithm>
+#include <chrono>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/filesystem.hpp>
@@ -26,6 +27,8 @@
 #include <ThePEG/Utilities/DynamicLoader.h>
 #include <ThePEG/Repository/Repository.h>
 #include <ThePEG/Handlers/EventHandler.h>
+#include <ThePEG/Handlers/StandardEventHandler.h>
+#include <ThePEG/Handlers/SamplerBase.h>
 #include <ThePEG/Handlers/XComb.h>
 #include <ThePEG/EventRecord/Event.h>
 #include <ThePEG/EventRecord/Particle.h> 
@@ -36,6 +39,8 @@
 #include <ThePEG/PDF/PDFBase.h>
 #include <ThePEG/Utilities/UtilityBase.h>
 #include <ThePEG/Vectors/HepMCConverter.h>
+#include <ThePEG/Persistency/PersistentOStream.h>
+#include <ThePEG/Persistency/PersistentIStream.h>
 
 
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
@@ -45,6 +50,13 @@
 #include "GeneratorInterface/Herwig7Interface/interface/Proxy.h"
 #include "GeneratorInterface/Herwig7Interface/interface/RandomEngineGlue.h"
 #include "GeneratorInterface/Herwig7Interface/interface/Herwig7Interface.h"
+#include "GeneratorInterface/Herwig7Interface/interface/CompactEventIO.h"
+#include "GeneratorInterface/Herwig7Interface/interface/CpuPlacement.h"
+#include "GeneratorInterface/Herwig7Interface/interface/IntegrationJobPlanner.h"
+#include "GeneratorInterface/Herwig7Interface/interface/MatrixElementCache.h"
+#include "GeneratorInterface/Herwig7Interface/interface/RepositorySnapshots.h"
+#include "GeneratorInterface/Herwig7Interface/interface/RunFilePruner.h"
+#include "GeneratorInterface/Herwig7Interface/interface/ScratchArchive.h"
 
 using namespace std;
 using namespace gen;
@@ -55,13 +67,83 @@ Herwig7Interface::Herwig7Interface(const edm::ParameterSet &pset) :
 	generator_(pset.getParameter<string>("generatorModule")),
 	run_(pset.getParameter<string>("run")),
 	dumpConfig_(pset.getUntrackedParameter<string>("dumpConfig", "HerwigConfig.in")),
-	skipEvents_(pset.getUntrackedParameter<unsigned int>("skipEvents", 0))
+	readInput_(dumpConfig_),
+	skipEvents_(pset.getUntrackedParameter<unsigned int>("skipEvents", 0)),
+	samplerStateFile_(pset.getUntrackedParameter<string>("samplerStateFile", "")),
+	samplerWarmupEvents_(pset.getUntrackedParameter<unsigned int>("samplerWarmupEvents", 0)),
+	snapshotDirectory_(pset.getUntrackedParameter<string>("repositorySnapshots", ""))
 {
-	// Write events in hepmc ascii format for debugging purposes
+	// Pin parallel workers first, so everything allocated afterwards is on their NUMA node.
+	// Herwig forks the build jobs itself, they share the CPUs of the worker. All threads
+	// of cmsRun are pinned, so the number of CPUs has to be given, never guessed.
+	CpuPlacement::Policy placement = CpuPlacement::policy(pset.getUntrackedParameter<string>("cpuPlacement", "none"));
+	if (placement != CpuPlacement::None) {
+		if (pset.exists("cpusPerWorker"))
+			CpuPlacement(placement).pin(pset.getUntrackedParameter<unsigned int>("workerIndex", 0),
+				pset.getUntrackedParameter<unsigned int>("cpusPerWorker"));
+		else
+			edm::LogWarning("Herwig7Interface") << "cpuPlacement without cpusPerWorker, the job is not pinned";
+	}
+	// Write events in hepmc ascii format for debugging purposes,
+	// or in the compact binary format for large private samples
 	string dumpEvents = pset.getUntrackedParameter<string>("dumpEvents", "");
 	if (!dumpEvents.empty()) {
-		iobc_.reset(new HepMC::IO_GenEvent(dumpEvents.c_str(), ios::out));
-		edm::LogInfo("ThePEGSource") << "Event logging switched on (=> " << dumpEvents << ")";
+		string dumpFormat = pset.getUntrackedParameter<string>("dumpEventsFormat", "ascii");
+		if (dumpFormat == "compact")
+			iobc_.reset(new CompactEventIO(dumpEvents, ios::out,
+				pset.getUntrackedParameter<bool>("dumpEventsQuantize", false),
+				pset.getUntrackedParameter<unsigned int>("dumpEventsBlockSize", 100)));
+		else if (dumpFormat == "ascii")
+			iobc_.reset(new HepMC::IO_GenEvent(dumpEvents.c_str(), ios::out));
+		else
+			throw cms::Exception("Herwig7Interface") << "Unknown dumpEventsFormat " << dumpFormat << ", use ascii or compact" << endl;
+		edm::LogInfo("ThePEGSource") << "Event logging switched on (=> " << dumpEvents << ", " << dumpFormat << ")";
+	}
+	// Further processes generated in the same job with fixed fractions of the events
+	vector<edm::ParameterSet> generatorModules = pset.getUntrackedParameter<vector<edm::ParameterSet> >("generatorModules", vector<edm::ParameterSet>());
+	if (!generatorModules.empty()) {
+		Process main = { generator_, run_, 1., ThePEG::EGPtr(), 0, 0., 0., 1. };
+		processes_.push_back(main);
+		for (vector<edm::ParameterSet>::const_iterator it = generatorModules.begin(); it != generatorModules.end(); ++it) {
+			Process process = { it->getUntrackedParameter<string>("generatorModule"), it->getUntrackedParameter<string>("run"),
+			                    it->getUntrackedParameter<double>("fraction"), ThePEG::EGPtr(), 0, 0., 0., 1. };
+			if (process.run == run_ || process.fraction <= 0.)
+				throw cms::Exception("Herwig7Interface") << "generatorModules entry " << process.generator
+									 << " needs its own run name and a positive fraction" << endl;
+			processes_[0].fraction -= process.fraction;
+			processes_.push_back(process);
+		}
+		if (processes_[0].fraction <= 0.)
+			throw cms::Exception("Herwig7Interface") << "The fractions of generatorModules leave no events for " << generator_ << endl;
+		edm::LogInfo("Herwig7Interface") << processes_.size() << " processes generated in one job";
+	}
+	// Analyses run in-process on the converted events
+	vector<edm::ParameterSet> analyses = pset.getUntrackedParameter<vector<edm::ParameterSet> >("analyses", vector<edm::ParameterSet>());
+	if (!analyses.empty()) {
+		analyses_.reset(new Herwig7AnalysisDispatcher(analyses,
+			pset.getUntrackedParameter<unsigned int>("analysisThreads", 0),
+			pset.getUntrackedParameter<unsigned int>("analysisQueueSize", 100)));
+		edm::LogInfo("Herwig7Interface") << analyses.size() << " in-process analyses switched on";
+	}
+	// Startup trace, snapshot of the mapped files before Herwig is started
+	string startupManifest = pset.getUntrackedParameter<string>("startupManifest", "");
+	if (!startupManifest.empty())
+		preloader_.reset(new StartupPreloader(startupManifest,
+			pset.getUntrackedParameter<unsigned int>("startupPreloadThreads", 8)));
+	// Throughput metrics for the batch monitoring
+	string metricsFile = pset.getUntrackedParameter<string>("metricsFile", "");
+	if (!metricsFile.empty()) {
+		metrics_.reset(new ThroughputMonitor(metricsFile,
+			pset.getUntrackedParameter<double>("metricsInterval", 30.),
+			pset.getUntrackedParameter<unsigned int>("metricsExpectedEvents", 0)));
+		edm::LogInfo("Herwig7Interface") << "Metrics export switched on (=> " << metricsFile << ")";
+	}
+	// Memory accounting of the generation loop, to attribute slow RSS growth
+	if (pset.getUntrackedParameter<bool>("profileMemory", false)) {
+		memoryProfiler_.reset(new PhaseMemoryProfiler(
+			pset.getUntrackedParameter<unsigned int>("memoryProfileWindow", 100),
+			pset.getUntrackedParameter<double>("memoryGrowthThreshold", 1.)));
+		edm::LogInfo("Herwig7Interface") << "Memory profiling of the generation phases switched on";
 	}
 	// Clear dumpConfig target
 	if (!dumpConfig_.empty())
@@ -70,6 +152,15 @@ Herwig7Interface::Herwig7Interface(const edm::ParameterSet &pset) :
 
 Herwig7Interface::~Herwig7Interface()
 {
+	if (memoryProfiler_.get())
+		memoryProfiler_->summary();
+	if (analyses_.get())
+		analyses_->finish();
+	for (size_t i = 1; i < processes_.size(); ++i)
+		if (processes_[i].eg)
+			processes_[i].eg->finalize();
+	if (!processes_.empty())
+		eg_ = processes_[0].eg;
 	if (eg_)
 		eg_->finalize();
 	edm::LogInfo("Herwig7Interface") << "Event generator finalized";
@@ -86,6 +177,16 @@ void Herwig7Interface::setPEGRandomEngine(CLHEP::HepRandomEngine* v) {
 
 void Herwig7Interface::initRepository(const edm::ParameterSet &pset)
 {
+	// Location of the integration job lists written by the build step
+	const std::string integrationDirectory("Herwig-scratch/Build");
+	// Single-file archive of Herwig-scratch for the integrate and run jobs
+	const std::string scratchArchive = pset.getUntrackedParameter<string>("scratchArchive", "");
+	// Lists of the other integration jobs are never needed
+	const vector<string> otherIntegrationJobs(1, "Build/integrationJob");
+
+	if (preloader_.get())
+		preloader_->prefetch();
+
 	std::string runModeTemp = pset.getUntrackedParameter<string>("runModeList","read,run");
 	// To Lower
 	std::transform(runModeTemp.begin(), runModeTemp.end(), runModeTemp.begin(), ::tolower);
@@ -103,30 +204,98 @@ void Herwig7Interface::initRepository(const edm::ParameterSet &pset)
 		// construct HerwigUIProvider object and return it as global object
 		HwUI_ = new Herwig::HerwigUIProvider(pset, dumpConfig_, Herwig::RunMode::READ);
 		edm::LogInfo("Herwig7Interface") << "HerwigUIProvider object with run mode " << HwUI_->runMode() << " created.\n";
+		// The library paths of the DynamicLoader are set now, the first step loads the recorded libraries
+		if (preloader_.get())
+			preloader_->preload();
 
 
 		// Chose run mode
 		if	( choice == "read" )
 		{
 			createInputFile(pset);
-			HwUI_->setRunMode(Herwig::RunMode::READ, pset, dumpConfig_);
-			edm::LogInfo("Herwig7Interface") << "Input file " << dumpConfig_ << " will be passed to Herwig for the read step.\n";
+			HwUI_->setRunMode(Herwig::RunMode::READ, pset, readInput_);
+			edm::LogInfo("Herwig7Interface") << "Input file " << readInput_ << " will be passed to Herwig for the read step.\n";
 			callHerwigGenerator();
+
+			if (pset.getUntrackedParameter<bool>("pruneRunFile", false))
+				pruneRunFile(pset);
 		}
 		else if	( choice == "build" )
 		{
 			createInputFile(pset);
-			HwUI_->setRunMode(Herwig::RunMode::BUILD, pset, dumpConfig_);
-			edm::LogInfo("Herwig7Interface") << "Input file " << dumpConfig_ << " will be passed to Herwig for the build step.\n";
+			HwUI_->setRunMode(Herwig::RunMode::BUILD, pset, readInput_);
+			edm::LogInfo("Herwig7Interface") << "Input file " << readInput_ << " will be passed to Herwig for the build step.\n";
+
+			// Compile external matrix elements in parallel and reuse earlier builds, on request only
+			unsigned int compileJobs = pset.getUntrackedParameter<unsigned int>("buildCompileJobs", 0);
+			std::string meCacheDirectory = pset.getUntrackedParameter<string>("meLibraryCache", "");
+			if (compileJobs || !meCacheDirectory.empty())
+				MatrixElementCache::setCompileJobs(compileJobs ? compileJobs : IntegrationJobPlanner::availableSlots());
+			std::auto_ptr<MatrixElementCache> meCache;
+			std::string meCacheKey;
+			bool meCacheHit = false;
+			if (!meCacheDirectory.empty()) {
+				meCache.reset(new MatrixElementCache(meCacheDirectory, "Herwig-scratch",
+					pset.getUntrackedParameter<vector<string> >("meLibraryDirectories", vector<string>(1, "Build/MadGraphAmplitudes"))));
+				meCacheKey = meCache->key(dumpConfig_);
+				meCacheHit = meCache->restore(meCacheKey);
+				edm::LogInfo("Herwig7Interface") << "Matrix element library cache " << (meCacheHit ? "hit" : "miss")
+								 << " for key " << meCacheKey;
+			}
+
 			callHerwigGenerator();
 
+			if (meCache.get() && !meCacheHit)
+				meCache->store(meCacheKey);
+
+			if (pset.getUntrackedParameter<bool>("pruneRunFile", false))
+				pruneRunFile(pset);
+
+			if (HwUI_->autoJobSize())
+				IntegrationJobPlanner(integrationDirectory).rebalance(HwUI_->integrationSlots());
+
+			if (!scratchArchive.empty())
+				packScratch(scratchArchive);
 		}
 		else if	( choice == "integrate" )
 		{
 			std::string runFileName = run_ + ".run";
 			edm::LogInfo("Herwig7Interface") << "Run file " << runFileName << " will be passed to Herwig for the integrate step.\n";
 			HwUI_->setRunMode(Herwig::RunMode::INTEGRATE, pset, runFileName);
+			if (!scratchArchive.empty()) {
+				// The bins are integrated from what the build step wrote to Build/ and the external
+				// matrix element libraries; grids of earlier runs and other jobs' lists are not needed
+				vector<string> prefixes(1, "Build/");
+				vector<string> libraries = pset.getUntrackedParameter<vector<string> >("meLibraryDirectories", vector<string>(1, "Build/MadGraphAmplitudes"));
+				for (size_t i = 0; i < libraries.size(); ++i)
+					prefixes.push_back(libraries[i] + "/");
+				unpackScratch(scratchArchive, prefixes, otherIntegrationJobs);
+				if (!HwUI_->integrationList().empty())
+					unpackScratch(scratchArchive, vector<string>(1, "Build/" + HwUI_->integrationList()), vector<string>());
+			}
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 			callHerwigGenerator();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (!HwUI_->integrationList().empty()) {
+				double predicted = IntegrationJobPlanner(integrationDirectory).recordRuntime(HwUI_->integrationList(), seconds);
+				stringstream logstream;
+				logstream << HwUI_->integrationList() << " finished after " << seconds << " s";
+				if (predicted >= 0.)
+					logstream << ", predicted " << predicted << " s";
+				edm::LogInfo("Herwig7Interface") << logstream.str();
+			}
+
+			// The grids of parallel integration jobs are packed by a later pack step
+			if (!scratchArchive.empty() && HwUI_->integrationList().empty())
+				packScratch(scratchArchive);
+		}
+		else if	( choice == "pack" )
+		{
+			if (scratchArchive.empty())
+				edm::LogWarning("Herwig7Interface") << "Pack step without scratchArchive, skipping it.\n";
+			else
+				packScratch(scratchArchive);
 
 		}
 		else if	( choice == "run" )
@@ -134,6 +303,20 @@ void Herwig7Interface::initRepository(const edm::ParameterSet &pset)
 			std::string runFileName = run_ + ".run";
 			edm::LogInfo("Herwig7Interface") << "Run file " << runFileName << " will be passed to Herwig for the run step.\n";
 			HwUI_->setRunMode(Herwig::RunMode::RUN, pset, runFileName);
+			if (!scratchArchive.empty()) {
+				// By default only what the run step reads: the run directories with the
+				// grids of the samplers and the external matrix element libraries.
+				// The run files themselves are in the working directory.
+				vector<string> prefixes(1, run_ + "/");
+				for (size_t i = 1; i < processes_.size(); ++i)
+					prefixes.push_back(processes_[i].run + "/");
+				vector<string> libraries = pset.getUntrackedParameter<vector<string> >("meLibraryDirectories", vector<string>(1, "Build/MadGraphAmplitudes"));
+				for (size_t i = 0; i < libraries.size(); ++i)
+					prefixes.push_back(libraries[i] + "/");
+				unpackScratch(scratchArchive,
+					pset.getUntrackedParameter<vector<string> >("scratchArchivePrefixes", prefixes),
+					otherIntegrationJobs);
+			}
 		}
 		else
 		{
@@ -151,6 +334,7 @@ void Herwig7Interface::callHerwigGenerator()
   try {
 
     edm::LogInfo("Herwig7Interface") << "callHerwigGenerator function invoked with run mode " << HwUI_->runMode() << ".\n";
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
     // Call program switches according to runMode
     switch ( HwUI_->runMode() ) {
@@ -168,6 +352,14 @@ void Herwig7Interface::callHerwigGenerator()
       HwUI_->quitWithHelp();
     }
 
+    // Snapshots of a read or build step which went through
+    if (snapshots_.get() && (HwUI_->runMode() == Herwig::RunMode::READ || HwUI_->runMode() == Herwig::RunMode::BUILD)) {
+      size_t committed = snapshots_->commit();
+      edm::LogInfo("Herwig7Interface") << committed << " repository snapshots stored in " << snapshotDirectory_;
+    }
+
+    edm::LogInfo("Herwig7Interface") << "Startup phase run mode " << HwUI_->runMode() << ": "
+                                     << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s";
     return;
 
   }
@@ -196,13 +388,143 @@ void Herwig7Interface::callHerwigGenerator()
 }
 
 
+void Herwig7Interface::pruneRunFile(const edm::ParameterSet &pset)
+{
+	std::string runFileName = run_ + ".run";
+	RunFilePruner before(runFileName);
+	if (!before.analyse())
+		return;
+	long sizeBefore = before.fileSize();
+	edm::LogInfo("Herwig7Interface") << "Run file " << runFileName << ": " << before.storedObjects() << " objects, "
+					 << before.reachableObjects() << " reachable from " << generator_ << ", "
+					 << sizeBefore << " bytes, " << before.loadedMemory() << " bytes RSS when loaded.";
+	if (!before.removableObjects()) {
+		edm::LogInfo("Herwig7Interface") << "No unreachable objects to prune.";
+		return;
+	}
+
+	// Repeating the step costs as much as the step itself, so only when loading the run file gets noticeably cheaper
+	double minimumSaving = pset.getUntrackedParameter<double>("pruneRunFileMinSaving", 50.) * 1024. * 1024.;
+	double estimatedSaving = before.storedObjects() ? double(before.loadedMemory()) * before.removableObjects() / before.storedObjects() : 0.;
+	if (estimatedSaving < minimumSaving) {
+		edm::LogInfo("Herwig7Interface") << "Pruning " << before.removableObjects() << " objects would save about "
+						 << estimatedSaving / (1024. * 1024.) << " MB RSS, below pruneRunFileMinSaving, run file kept.";
+		return;
+	}
+
+	// Repeat the step with the unreachable objects removed before saverun
+	Herwig::RunMode::Mode mode = HwUI_->runMode();
+	pruneCommands_.assign(1, before.removeCommand());
+	ofstream cfgDump(dumpConfig_.c_str(), ios_base::trunc);
+	cfgDump.close();
+	createInputFile(pset);
+	pruneCommands_.clear();
+	edm::LogInfo("Herwig7Interface") << "Repeating step to prune " << before.removableObjects() << " objects.";
+	HwUI_->setRunMode(mode, pset, readInput_);
+	callHerwigGenerator();
+
+	// This process has loaded the run file before, its RSS says nothing about the pruned file
+	RunFilePruner after(runFileName);
+	if (after.analyse())
+		edm::LogInfo("Herwig7Interface") << "Pruned run file " << runFileName << ": " << after.storedObjects() << " objects, "
+						 << after.fileSize() << " bytes, before " << before.storedObjects() << " objects, "
+						 << sizeBefore << " bytes.";
+}
+
+void Herwig7Interface::packScratch(const std::string &archive)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t entries = ScratchArchive::pack("Herwig-scratch", archive);
+	edm::LogInfo("Herwig7Interface") << "Herwig-scratch packed into " << archive << ": " << entries << " files in "
+					 << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s";
+}
+
+void Herwig7Interface::unpackScratch(const std::string &archive, const std::vector<std::string> &prefixes,
+                                     const std::vector<std::string> &excluded)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ScratchArchive scratch(archive);
+	if (!scratch.valid()) {
+		edm::LogWarning("Herwig7Interface") << "Scratch archive " << archive << " not found, using Herwig-scratch as it is";
+		return;
+	}
+	size_t extracted = scratch.extract("Herwig-scratch", prefixes, excluded);
+	edm::LogInfo("Herwig7Interface") << "Startup phase scratch archive: " << extracted << " of " << scratch.entries()
+					 << " files extracted from " << archive << " in "
+					 << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s";
+}
+
 bool Herwig7Interface::initGenerator()
 {
 	if ( HwUI_->runMode() == Herwig::RunMode::RUN) {
 		edm::LogInfo("Herwig7Interface") << "Starting EventGenerator initialization";
-		callHerwigGenerator();
+		// An adapted sampler state replaces the run file of the integrate step
+		bool stateLoaded = !samplerStateFile_.empty() && !samplerWarmupEvents_ &&
+		                   boost::filesystem::exists(samplerStateFile_) &&
+		                   loadGeneratorState(samplerStateFile_);
+		if (!stateLoaded)
+			callHerwigGenerator();
 		edm::LogInfo("Herwig7Interface") << "EventGenerator initialized";
 
+		// Every further process is prepared from its own run file, only the libraries are loaded once
+		if (!processes_.empty() && eg_) {
+			processes_[0].eg = eg_;
+			std::string mainRunFile = HwUI_->inputfile();
+			for (size_t i = 1; i < processes_.size(); ++i) {
+				if (processes_[i].eg)
+					continue;
+				HwUI_->setRunMode(Herwig::RunMode::RUN, edm::ParameterSet(), processes_[i].run + ".run");
+				callHerwigGenerator();
+				processes_[i].eg = eg_;
+				if (!eg_)
+					throw cms::Exception("Herwig7Interface") << "Run file " << processes_[i].run << ".run of "
+										 << processes_[i].generator << " could not be prepared" << endl;
+				edm::LogInfo("Herwig7Interface") << "EventGenerator " << processes_[i].generator << " of process "
+								 << i << " initialized";
+			}
+			HwUI_->setRunMode(Herwig::RunMode::RUN, edm::ParameterSet(), mainRunFile);
+			eg_ = processes_[0].eg;
+
+			// Events of process i stand for sigma_i / (fraction_i * N) each, the weights
+			// make the sum of the cross sections the normalization of the whole sample
+			double total = 0.;
+			for (size_t i = 0; i < processes_.size(); ++i) {
+				processes_[i].xsec = processes_[i].eg->integratedXSec() / ThePEG::picobarn;
+				processes_[i].xsecErr = processes_[i].eg->integratedXSecErr() / ThePEG::picobarn;
+				total += processes_[i].xsec;
+			}
+			if (total <= 0.)
+				throw cms::Exception("Herwig7Interface") << "The generators of generatorModules have no cross section to weight their events with" << endl;
+			for (size_t i = 0; i < processes_.size(); ++i) {
+				processes_[i].weight = processes_[i].xsec / (processes_[i].fraction * total);
+				edm::LogInfo("Herwig7Interface") << "Process " << i << " (" << processes_[i].generator << "): cross section "
+								 << processes_[i].xsec << " pb, fraction " << processes_[i].fraction
+								 << ", event weight factor " << processes_[i].weight;
+			}
+		}
+
+		if (preloader_.get()) {
+			preloader_->addFile(HwUI_->repository());
+			preloader_->addFile(HwUI_->inputfile());
+			preloader_->record();
+		}
+
+		if (stateLoaded)
+			edm::LogInfo("Herwig7Interface") << "Sampler state loaded from " << samplerStateFile_
+							 << ", unweighting efficiency " << unweightingEfficiency();
+
+		// Adapt the sampler and save its state for the following run jobs
+		if (samplerWarmupEvents_ && !samplerStateFile_.empty()) {
+			for (unsigned int i = 0; i < samplerWarmupEvents_; i++) {
+				flushRandomNumberGenerator();
+				eg_->shoot();
+			}
+			saveGeneratorState(samplerStateFile_);
+			edm::LogInfo("Herwig7Interface") << "Sampler state saved to " << samplerStateFile_ << " after "
+							 << samplerWarmupEvents_ << " warm-up events, unweighting efficiency "
+							 << unweightingEfficiency();
+		}
+
 		// Skip events
 		for (unsigned int i = 0; i < skipEvents_; i++) {
 			flushRandomNumberGenerator();
@@ -223,6 +545,85 @@ bool Herwig7Interface::initGenerator()
 
 }
 
+unsigned int Herwig7Interface::selectProcess()
+{
+	// Deterministic interleaving, the process furthest behind its fraction is next
+	unsigned long total = 1;
+	for (size_t i = 0; i < processes_.size(); ++i)
+		total += processes_[i].events;
+	size_t next = 0;
+	double maxDeficit = -1.;
+	for (size_t i = 0; i < processes_.size(); ++i) {
+		double deficit = processes_[i].fraction * total - processes_[i].events;
+		if (deficit > maxDeficit) {
+			maxDeficit = deficit;
+			next = i;
+		}
+	}
+	++processes_[next].events;
+	eg_ = processes_[next].eg;
+	return next;
+}
+
+bool Herwig7Interface::loadGeneratorState(const std::string &fileName)
+{
+	try {
+		ThePEG::PersistentIStream is(fileName);
+		is >> eg_;
+		if (!eg_)
+			return false;
+		// Settings prepareRun applies to the generator loaded from the run file.
+		// The seed is always replaced, a loaded state must not keep the one of the job which saved it
+		eg_->setSeed(HwUI_->seed());
+		// The state was saved from a prepared generator, which may carry the tag already
+		const std::string &tag = HwUI_->tag();
+		const std::string runName = eg_->runName();
+		if (!tag.empty() && (runName.size() < tag.size() || runName.compare(runName.size() - tag.size(), tag.size(), tag) != 0))
+			eg_->addTag(tag);
+		eg_->initialize();
+		return true;
+	}
+	catch ( ThePEG::Exception & e ) {
+		edm::LogWarning("Herwig7Interface") << "Could not load generator state from " << fileName << ": " << e.what();
+		eg_ = ThePEG::EGPtr();
+		return false;
+	}
+}
+
+void Herwig7Interface::saveGeneratorState(const std::string &fileName) const
+{
+	ThePEG::PersistentOStream os(fileName, eg_->globalLibraries());
+	os << eg_;
+}
+
+double Herwig7Interface::unweightingEfficiency() const
+{
+	ThePEG::tStdEHPtr eh = ThePEG::dynamic_ptr_cast<ThePEG::tStdEHPtr>(eg_->eventHandler());
+	if (!eh || !eh->sampler() || eh->sampler()->maxXSec() <= ThePEG::ZERO)
+		return -1.0;
+	return eg_->integratedXSec() / eh->sampler()->maxXSec();
+}
+
+bool Herwig7Interface::samplerStatistics(double &attempts, double &maxXSec) const
+{
+	ThePEG::tStdEHPtr eh = ThePEG::dynamic_ptr_cast<ThePEG::tStdEHPtr>(eg_->eventHandler());
+	if (!eh || !eh->sampler())
+		return false;
+	attempts = eh->sampler()->attempts();
+	maxXSec = eh->sampler()->maxXSec() / ThePEG::picobarn;
+	return true;
+}
+
+void Herwig7Interface::exportMetrics()
+{
+	if (!metrics_.get() || !metrics_->due())
+		return;
+
+	metrics_->setCrossSection(eg_->integratedXSec() / ThePEG::picobarn,
+	                          eg_->integratedXSecErr() / ThePEG::picobarn);
+	metrics_->write();
+}
+
 void Herwig7Interface::flushRandomNumberGenerator()
 {
 	/*ThePEG::RandomEngineGlue *rnd = randomEngineGlueProxy_->getInstance();
@@ -280,6 +681,8 @@ void Herwig7Interface::createInputFile(const edm::ParameterSet &pset)
 
 	// Contains input config passed to Herwig
 	stringstream herwiginputconfig;
+	// Ends of the command blocks the repository snapshots are taken after
+	vector<size_t> blockEnds;
 
 	// Define output file to which input config is written, too, if dumpConfig parameter is set. 
 	// Otherwise use default file HerwigConfig.in which is read in by Herwig
@@ -307,6 +710,7 @@ void Herwig7Interface::createInputFile(const edm::ParameterSet &pset)
 				configFileContent.insert(configFileContent.find(searchKeyword),"#");
 			}
 			herwiginputconfig << "# Begin Config file input" << endl  << configFileContent << endl << "# End Config file input";
+			blockEnds.push_back(herwiginputconfig.tellp());
 			edm::LogInfo("Herwig7Interface") << "Finished reading config file (" << *iter << ")" << endl;
 		}
 		else {
@@ -318,14 +722,45 @@ void Herwig7Interface::createInputFile(const edm::ParameterSet &pset)
 	// Read CMSSW config file parameter sets starting from "parameterSets"
 	ParameterCollector collector(pset);
 	ParameterCollector::const_iterator iter;
-	iter = collector.begin();
 	herwiginputconfig << endl << "# Begin Parameter set input\n" << endl;
-	for(; iter != collector.end(); ++iter) {
-		herwiginputconfig << *iter << endl;
+	vector<string> parameterSets = pset.getParameter<vector<string> >("parameterSets");
+	for(vector<string>::const_iterator block = parameterSets.begin(); block != parameterSets.end(); ++block) {
+		for(iter = collector.begin(*block); iter != collector.end(); ++iter) {
+			herwiginputconfig << *iter << endl;
+		}
+		blockEnds.push_back(herwiginputconfig.tellp());
+	}
+
+	// Bias the sampling towards high pT, the events carry the compensating weight
+	if (pset.exists("biasing")) {
+		edm::ParameterSet biasing = pset.getUntrackedParameter<edm::ParameterSet>("biasing");
+		string reweighter = biasing.getUntrackedParameter<string>("reweighter", "");
+		herwiginputconfig << "# Begin biasing" << endl << "cd /" << endl;
+		if (reweighter.empty()) {
+			reweighter = "/Herwig/Weights/cmsBiasMinPT";
+			herwiginputconfig << "mkdir /Herwig/Weights" << endl
+			                  << "create ThePEG::ReweightMinPT " << reweighter << " ReweightMinPT.so" << endl
+			                  << "set " << reweighter << ":Power " << biasing.getUntrackedParameter<double>("power") << endl
+			                  << "set " << reweighter << ":Scale " << biasing.getUntrackedParameter<double>("scale") << "*GeV" << endl;
+		}
+		herwiginputconfig << "insert " << biasing.getUntrackedParameter<string>("matrixElement") << ":Preweights[0] " << reweighter << endl
+		                  << "# End biasing" << endl;
+		blockEnds.push_back(herwiginputconfig.tellp());
+	}
+
+	// Remove objects found to be unreachable by an earlier pass
+	if (!pruneCommands_.empty()) {
+		herwiginputconfig << "# Begin pruning of unused objects" << endl << "cd /" << endl;
+		for(vector<string>::const_iterator cmd = pruneCommands_.begin(); cmd != pruneCommands_.end(); ++cmd)
+			herwiginputconfig << *cmd << endl;
+		herwiginputconfig << "# End pruning of unused objects" << endl;
+		blockEnds.push_back(herwiginputconfig.tellp());
 	}
 
 	// Add some additional necessary lines to the Herwig input config
 	herwiginputconfig << "saverun " << run_ << " " << generator_ << endl;
+	for(size_t i = 1; i < processes_.size(); ++i)
+		herwiginputconfig << "saverun " << processes_[i].run << " " << processes_[i].generator << endl;
 	// write the ProxyID for the RandomEngineGlue to fill its pointer in
 	ostringstream ss;
 	ss << randomEngineGlueProxy_->getID();
@@ -335,5 +770,31 @@ void Herwig7Interface::createInputFile(const edm::ParameterSet &pset)
 	// Dump Herwig input config to file, so that it can be read by Herwig
 	cfgDump << herwiginputconfig.str() << endl;
 	cfgDump.close();
+	readInput_ = dumpConfig_;
+
+	// Herwig reads only the blocks after the longest unchanged prefix, the full config stays in dumpConfig
+	if (!snapshotDirectory_.empty()) {
+		string repository = snapshots_.get() ? snapshots_->baseRepository() : HwUI_->repository();
+		// Where the read step looks for files read by the config
+		vector<string> readDirectories(HwUI_->prependReadDirectories());
+		readDirectories.push_back("");
+		readDirectories.insert(readDirectories.end(), HwUI_->appendReadDirectories().begin(), HwUI_->appendReadDirectories().end());
+		readDirectories.push_back(dataLocation_);
+		snapshots_.reset(new RepositorySnapshots(snapshotDirectory_, repository, readDirectories));
+		string config = herwiginputconfig.str();
+		size_t begin = 0;
+		for (vector<size_t>::const_iterator end = blockEnds.begin(); end != blockEnds.end(); begin = *end++)
+			snapshots_->addBlock(config.substr(begin, *end - begin));
+
+		readInput_ = dumpConfig_ + ".delta";
+		ofstream delta(readInput_.c_str(), ios_base::trunc);
+		delta << snapshots_->input() << config.substr(begin) << endl;
+		delta.close();
+		HwUI_->setRepository(snapshots_->repository());
+		edm::LogInfo("Herwig7Interface") << "Repository snapshot " << snapshots_->repository() << " restores "
+						 << snapshots_->restoredBlocks() << " of " << snapshots_->blocks()
+						 << " command blocks (" << snapshots_->snapshotBlocks() << " can be snapshotted),"
+						 << " the others are read from " << readInput_;
+	}
 }
 
@@ -8,6 +8,7 @@ Dominik Beutel
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 #include "GeneratorInterface/Core/interface/ParameterCollector.h"
 #include "GeneratorInterface/Herwig7Interface/interface/RandomEngineGlue.h"
+#include "GeneratorInterface/Herwig7Interface/interface/IntegrationJobPlanner.h"
 
 #include <ThePEG/Utilities/DynamicLoader.h>
 #include <ThePEG/Utilities/Debug.h>
@@ -37,7 +38,8 @@ HerwigUIProvider::HerwigUIProvider(const edm::ParameterSet &pset, std::string in
     inputfile_(inputFileName), repository_(), setupfile_(),
     integrationList_(),
     N_(-1), seed_(0), jobs_(1),
-    jobsize_(0), maxjobs_(0)
+    jobsize_(0), maxjobs_(0),
+    autoJobSize_(false), integrationSlots_(0)
 {
 
   // check runMode of program and terminate if error state
@@ -128,8 +130,20 @@ HerwigUIProvider::HerwigUIProvider(const edm::ParameterSet &pset, std::string in
 
 
 
+  // automatic job sizing, one bin per job is written and merged after the build step
+  if ( pset.getUntrackedParameter<bool>("autoJobSize", false) ) {
+    autoJobSize_ = true;
+    integrationSlots_ = pset.getUntrackedParameter<unsigned int>("integrationSlots", 0);
+    if ( integrationSlots_ == 0 )
+      integrationSlots_ = IntegrationJobPlanner::availableSlots();
+    if ( runMode_ == RunMode::BUILD ) {
+      jobsize_ = 1;
+      ThePEG::SamplerBase::setIntegratePerJob(jobsize_);
+    }
+  }
+
   // job size
-  if ( pset.getUntrackedParameter<unsigned int>("jobSize", 0) != 0 ) {
+  if ( pset.getUntrackedParameter<unsigned int>("jobSize", 0) != 0 && !autoJobSize_ ) {
     if ( runMode_ == RunMode::BUILD ) {
       jobsize_ = pset.getUntrackedParameter<unsigned int>("jobSize", 1);
       ThePEG::SamplerBase::setIntegratePerJob(jobsize_);
@@ -137,7 +151,7 @@ HerwigUIProvider::HerwigUIProvider(const edm::ParameterSet &pset, std::string in
   }
 
   // max integration jobs
-  if ( pset.getUntrackedParameter<unsigned int>("maxJobs", 0) != 0 ) {
+  if ( pset.getUntrackedParameter<unsigned int>("maxJobs", 0) != 0 && !autoJobSize_ ) {
     if ( runMode_ == RunMode::BUILD ) {
       maxjobs_ = pset.getUntrackedParameter<unsigned int>("maxJobs", 1);
       ThePEG::SamplerBase::setIntegrationJobs(maxjobs_);
@@ -163,7 +177,15 @@ void HerwigUIProvider::setRunMode(RunMode::Mode runMode, const edm::ParameterSet
 		inputfile_ = inputFile;
 
 	/* If build mode is chosen set these parameters accordingly, else unset them.*/
-	if (runMode_ == RunMode::BUILD)
+	if (runMode_ == RunMode::BUILD && autoJobSize_)
+	{
+		// finest partition, the jobs are merged again by the IntegrationJobPlanner
+		jobsize_ = 1;
+		ThePEG::SamplerBase::setIntegratePerJob(jobsize_);
+		maxjobs_ = 0;
+		ThePEG::SamplerBase::setIntegrationJobs(maxjobs_);
+	}
+	else if (runMode_ == RunMode::BUILD)
 	{
 		// job size
 		if ( pset.getUntrackedParameter<unsigned int>("jobSize", 0) != 0 )
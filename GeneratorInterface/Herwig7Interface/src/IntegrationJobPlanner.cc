@@ -0,0 +1,169 @@
+/** \class IntegrationJobPlanner
+ *
+ *  Automatic sizing of the integration jobs
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/regex.hpp>
+#include <boost/thread.hpp>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/IntegrationJobPlanner.h"
+
+using namespace std;
+
+namespace {
+	const char *costFileName = "integrationCosts";
+	const char *planFileName = "integrationPlan";
+}
+
+IntegrationJobPlanner::IntegrationJobPlanner(const string &buildDirectory) :
+	buildDirectory_(buildDirectory)
+{
+}
+
+unsigned int IntegrationJobPlanner::availableSlots()
+{
+	return max(1u, boost::thread::hardware_concurrency());
+}
+
+string IntegrationJobPlanner::jobFile(const string &name) const
+{
+	return (boost::filesystem::path(buildDirectory_) / name).string();
+}
+
+bool IntegrationJobPlanner::readJobs(map<string, BinList> &jobs) const
+{
+	namespace fs = boost::filesystem;
+	static const boost::regex jobName("integrationJob[0-9]+");
+
+	if (!fs::is_directory(buildDirectory_))
+		return false;
+
+	for (fs::directory_iterator it(buildDirectory_); it != fs::directory_iterator(); ++it) {
+		string name = it->path().filename().string();
+		if (!boost::regex_match(name, jobName))
+			continue;
+		if (!fs::is_regular_file(it->path())) {
+			edm::LogWarning("Herwig7Interface") << "Integration job " << name << " is not a plain bin list, "
+							    << "automatic job sizing is not possible.";
+			return false;
+		}
+		ifstream in(it->path().string().c_str());
+		BinList &bins = jobs[name];
+		int bin;
+		while (in >> bin)
+			bins.push_back(bin);
+	}
+	return !jobs.empty();
+}
+
+map<int, double> IntegrationJobPlanner::readCosts() const
+{
+	map<int, double> costs;
+	ifstream in(jobFile(costFileName).c_str());
+	int bin;
+	double seconds;
+	// Later records replace earlier ones
+	while (in >> bin >> seconds)
+		costs[bin] = seconds;
+	return costs;
+}
+
+bool IntegrationJobPlanner::rebalance(unsigned int slots)
+{
+	map<string, BinList> jobs;
+	if (!readJobs(jobs)) {
+		edm::LogWarning("Herwig7Interface") << "No integration jobs found in " << buildDirectory_
+						    << ", automatic job sizing skipped.";
+		return false;
+	}
+
+	BinList bins;
+	for (map<string, BinList>::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+		bins.insert(bins.end(), it->second.begin(), it->second.end());
+
+	// Cost estimate per bin from earlier integrations
+	map<int, double> costs = readCosts();
+	double meanCost = 1.0;
+	if (!costs.empty()) {
+		meanCost = 0.0;
+		for (map<int, double>::const_iterator it = costs.begin(); it != costs.end(); ++it)
+			meanCost += it->second;
+		meanCost /= costs.size();
+	}
+	vector<pair<double, int> > binCosts;
+	for (size_t i = 0; i < bins.size(); ++i) {
+		map<int, double>::const_iterator pos = costs.find(bins[i]);
+		binCosts.push_back(make_pair(pos != costs.end() ? pos->second : meanCost, bins[i]));
+	}
+	sort(binCosts.begin(), binCosts.end(), greater<pair<double, int> >());
+
+	// Longest processing time first: next most expensive bin to the least loaded job
+	unsigned int nJobs = max(1u, min<unsigned int>(slots, binCosts.size()));
+	vector<BinList> newJobs(nJobs);
+	vector<double> load(nJobs, 0.0);
+	typedef pair<double, unsigned int> Slot;
+	priority_queue<Slot, vector<Slot>, greater<Slot> > queue;
+	for (unsigned int i = 0; i < nJobs; ++i)
+		queue.push(Slot(0.0, i));
+	for (size_t i = 0; i < binCosts.size(); ++i) {
+		Slot slot = queue.top();
+		queue.pop();
+		newJobs[slot.second].push_back(binCosts[i].second);
+		load[slot.second] += binCosts[i].first;
+		queue.push(Slot(load[slot.second], slot.second));
+	}
+
+	for (map<string, BinList>::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+		boost::filesystem::remove(jobFile(it->first));
+
+	// Without recorded runtimes every bin costs the same and there is no prediction in seconds
+	ofstream plan(jobFile(planFileName).c_str(), ios_base::trunc);
+	for (unsigned int i = 0; i < nJobs; ++i) {
+		ostringstream name;
+		name << "integrationJob" << i;
+		ofstream out(jobFile(name.str()).c_str(), ios_base::trunc);
+		for (size_t j = 0; j < newJobs[i].size(); ++j)
+			out << newJobs[i][j] << " ";
+		out << endl;
+		plan << name.str() << " " << (costs.empty() ? -1.0 : load[i]) << endl;
+		if (costs.empty())
+			edm::LogInfo("Herwig7Interface") << name.str() << ": " << newJobs[i].size() << " bins, no recorded runtimes";
+		else
+			edm::LogInfo("Herwig7Interface") << name.str() << ": " << newJobs[i].size() << " bins, predicted runtime "
+							 << load[i] << " s";
+	}
+
+	edm::LogInfo("Herwig7Interface") << bins.size() << " integration bins in " << jobs.size()
+					 << " jobs repartitioned into " << nJobs << " jobs for " << slots << " slots.";
+	return true;
+}
+
+double IntegrationJobPlanner::recordRuntime(const string &integrationList, double seconds)
+{
+	map<string, BinList> jobs;
+	readJobs(jobs);
+	map<string, BinList>::const_iterator job = jobs.find(integrationList);
+	if (job != jobs.end() && !job->second.empty()) {
+		// The runtime is shared equally by the bins of the job
+		ofstream costs(jobFile(costFileName).c_str(), ios_base::app);
+		for (size_t i = 0; i < job->second.size(); ++i)
+			costs << job->second[i] << " " << seconds / job->second.size() << endl;
+	}
+
+	ifstream plan(jobFile(planFileName).c_str());
+	string name;
+	double predicted;
+	while (plan >> name >> predicted)
+		if (name == integrationList)
+			return predicted;
+	return -1.0;
+}
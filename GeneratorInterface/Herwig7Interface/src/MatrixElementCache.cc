@@ -0,0 +1,139 @@
+/** \class MatrixElementCache
+ *
+ *  Cache of the compiled external matrix element libraries
+ */
+
+#include <cstdlib>
+#include <sstream>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/ContentHash.h"
+#include "GeneratorInterface/Herwig7Interface/interface/MatrixElementCache.h"
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace {
+	void copyRecursive(const fs::path &from, const fs::path &to)
+	{
+		if (fs::is_symlink(from)) {
+			fs::copy_symlink(from, to);
+		} else if (fs::is_directory(from)) {
+			fs::create_directories(to);
+			for (fs::directory_iterator it(from); it != fs::directory_iterator(); ++it)
+				copyRecursive(it->path(), to / it->path().filename());
+		} else {
+			fs::copy_file(from, to, fs::copy_option::overwrite_if_exists);
+		}
+	}
+}
+
+MatrixElementCache::MatrixElementCache(const string &cacheDirectory,
+                                       const string &scratchDirectory,
+                                       const vector<string> &libraryDirectories) :
+	cacheDirectory_(cacheDirectory),
+	scratchDirectory_(scratchDirectory),
+	libraryDirectories_(libraryDirectories)
+{
+}
+
+string MatrixElementCache::key(const string &inputFile) const
+{
+	ContentHash hash;
+	if (!hash.updateFile(inputFile))
+		edm::LogWarning("Herwig7Interface") << "Could not read " << inputFile << " for the matrix element cache key.";
+
+	// Compiler and environment the libraries were built with
+	const char *variables[] = { "SCRAM_ARCH", "CMSSW_VERSION", "CXX", "CXXFLAGS", "FC", "FFLAGS", "HERWIGPATH", 0 };
+	for (const char **var = variables; *var; ++var) {
+		const char *value = getenv(*var);
+		hash.update(string(*var) + "=" + (value ? value : ""));
+	}
+	for (size_t i = 0; i < libraryDirectories_.size(); ++i)
+		hash.update(libraryDirectories_[i]);
+
+	return hash.hex();
+}
+
+bool MatrixElementCache::restore(const string &key) const
+{
+	fs::path entry = fs::path(cacheDirectory_) / key;
+	if (!fs::is_directory(entry))
+		return false;
+
+	for (size_t i = 0; i < libraryDirectories_.size(); ++i) {
+		fs::path cached = entry / libraryDirectories_[i];
+		fs::path target = fs::path(scratchDirectory_) / libraryDirectories_[i];
+		if (!fs::exists(cached))
+			continue;
+		if (fs::exists(target) || fs::is_symlink(target)) {
+			edm::LogInfo("Herwig7Interface") << target.string() << " exists already, cached version not used.";
+			continue;
+		}
+		// Copied rather than linked, the build writes into these directories
+		// and must not modify the entry shared with other jobs
+		ostringstream tmpName;
+		tmpName << target.filename().string() << ".tmp" << getpid();
+		fs::path tmp = target.parent_path() / tmpName.str();
+		try {
+			fs::create_directories(target.parent_path());
+			copyRecursive(cached, tmp);
+			fs::rename(tmp, target);
+		} catch (fs::filesystem_error &e) {
+			edm::LogWarning("Herwig7Interface") << "Could not copy cached matrix element libraries " << cached.string()
+							    << ": " << e.what();
+			boost::system::error_code ec;
+			fs::remove_all(tmp, ec);
+			return false;
+		}
+		edm::LogInfo("Herwig7Interface") << "Copied cached matrix element libraries " << cached.string()
+						 << " to " << target.string();
+	}
+	return true;
+}
+
+void MatrixElementCache::store(const string &key) const
+{
+	fs::path entry = fs::path(cacheDirectory_) / key;
+	if (fs::exists(entry))
+		return;
+
+	// Fill a temporary entry first, so concurrent jobs never see a partial one
+	ostringstream tmpName;
+	tmpName << key << ".tmp" << getpid();
+	fs::path tmp = fs::path(cacheDirectory_) / tmpName.str();
+	try {
+		bool found = false;
+		for (size_t i = 0; i < libraryDirectories_.size(); ++i) {
+			fs::path built = fs::path(scratchDirectory_) / libraryDirectories_[i];
+			if (!fs::is_directory(built) || fs::is_symlink(built))
+				continue;
+			copyRecursive(built, tmp / libraryDirectories_[i]);
+			found = true;
+		}
+		if (!found) {
+			edm::LogInfo("Herwig7Interface") << "No external matrix element libraries found to cache.";
+			return;
+		}
+		fs::rename(tmp, entry);
+		edm::LogInfo("Herwig7Interface") << "Stored matrix element libraries in cache " << entry.string();
+	} catch (fs::filesystem_error &e) {
+		edm::LogWarning("Herwig7Interface") << "Could not store matrix element libraries in cache: " << e.what();
+		boost::system::error_code ec;
+		fs::remove_all(tmp, ec);
+	}
+}
+
+void MatrixElementCache::setCompileJobs(unsigned int jobs)
+{
+	ostringstream flags;
+	flags << "-j" << jobs;
+	setenv("MAKEFLAGS", flags.str().c_str(), 1);
+	edm::LogInfo("Herwig7Interface") << "External matrix element code is compiled with " << flags.str();
+}
@@ -0,0 +1,143 @@
+/** \class ParameterScan
+ *
+ *  Parameter points applied to the live generator
+ */
+
+#include <map>
+#include <set>
+#include <sstream>
+
+#include <ThePEG/Handlers/EventHandler.h>
+#include <ThePEG/Handlers/SamplerBase.h>
+#include <ThePEG/Handlers/StandardEventHandler.h>
+#include <ThePEG/Interface/InterfaceBase.h>
+#include <ThePEG/Repository/BaseRepository.h>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/ParameterScan.h"
+
+using namespace std;
+
+ParameterScan::ParameterScan(const vector<edm::ParameterSet> &points) :
+	current_(points.size())
+{
+	for (size_t i = 0; i < points.size(); ++i) {
+		ostringstream name;
+		name << "point" << i;
+		Point point;
+		point.name = points[i].getUntrackedParameter<string>("name", name.str());
+		point.commands = points[i].getUntrackedParameter<vector<string> >("commands");
+		point.events = 0;
+		point.xsec = point.xsecErr = 0.;
+		points_.push_back(point);
+	}
+}
+
+void ParameterScan::apply(const ThePEG::EGPtr &eg, const Point &point)
+{
+	set<ThePEG::IBPtr> changed;
+	for (vector<string>::const_iterator cmd = point.commands.begin(); cmd != point.commands.end(); ++cmd) {
+		istringstream words(*cmd);
+		string verb, path, value;
+		words >> verb >> path;
+		getline(words >> ws, value);
+		size_t colon = path.rfind(':');
+		ThePEG::IBPtr object = verb == "set" && colon != string::npos ? eg->getPointer(path.substr(0, colon)) : ThePEG::IBPtr();
+		const ThePEG::InterfaceBase *interface = object ? ThePEG::BaseRepository::FindInterface(object, path.substr(colon + 1)) : 0;
+		if (!interface)
+			throw cms::Exception("Herwig7Interface") << "Scan point " << point.name << ": cannot apply \"" << *cmd
+								 << "\", only \"set object:interface value\" of the run is supported" << endl;
+		interface->exec(*object, "set", value);
+		changed.insert(object);
+	}
+
+	// The event handler and its sampler always, their statistics start anew with every point
+	changed.insert(eg->eventHandler());
+	ThePEG::tStdEHPtr eh = ThePEG::dynamic_ptr_cast<ThePEG::tStdEHPtr>(eg->eventHandler());
+	if (eh && eh->sampler())
+		changed.insert(eh->sampler());
+
+	// Every object referring to a changed one, directly or through others, may have derived
+	// values from it in doinit or doinitrun (decayers and width generators from masses and
+	// couplings, the event handler and sampler from the cross section), so all of them are
+	// initialized again. The generator itself is not, that would restart the whole run.
+	map<ThePEG::IBPtr, vector<ThePEG::IBPtr> > referrers;
+	for (ThePEG::ObjectSet::const_iterator it = eg->objects().begin(); it != eg->objects().end(); ++it) {
+		ThePEG::IVector references = (*it)->getReferences();
+		for (ThePEG::IVector::const_iterator ref = references.begin(); ref != references.end(); ++ref)
+			if (*ref)
+				referrers[*ref].push_back(*it);
+	}
+	set<ThePEG::IBPtr> affected;
+	vector<ThePEG::IBPtr> pending(changed.begin(), changed.end());
+	while (!pending.empty()) {
+		ThePEG::IBPtr object = pending.back();
+		pending.pop_back();
+		if (object == ThePEG::IBPtr(eg) || !affected.insert(object).second)
+			continue;
+		const vector<ThePEG::IBPtr> &users = referrers[object];
+		pending.insert(pending.end(), users.begin(), users.end());
+	}
+
+	// Referenced objects first, so every object sees the new values of what it uses
+	vector<ThePEG::IBPtr> order;
+	set<ThePEG::IBPtr> visited;
+	for (set<ThePEG::IBPtr>::const_iterator it = affected.begin(); it != affected.end(); ++it)
+		initOrder(*it, affected, visited, order);
+
+	for (vector<ThePEG::IBPtr>::const_iterator it = order.begin(); it != order.end(); ++it)
+		(*it)->reset();
+	for (vector<ThePEG::IBPtr>::const_iterator it = order.begin(); it != order.end(); ++it)
+		(*it)->init();
+	for (vector<ThePEG::IBPtr>::const_iterator it = order.begin(); it != order.end(); ++it)
+		(*it)->initrun();
+	edm::LogInfo("Herwig7Interface") << "Scan point " << point.name << ": " << point.commands.size() << " settings changed, "
+					 << order.size() << " objects initialized again";
+}
+
+void ParameterScan::initOrder(const ThePEG::IBPtr &object, const set<ThePEG::IBPtr> &affected,
+                              set<ThePEG::IBPtr> &visited, vector<ThePEG::IBPtr> &order)
+{
+	if (!visited.insert(object).second)
+		return;
+	ThePEG::IVector references = object->getReferences();
+	for (ThePEG::IVector::const_iterator ref = references.begin(); ref != references.end(); ++ref)
+		if (*ref && affected.count(*ref))
+			initOrder(*ref, affected, visited, order);
+	order.push_back(object);
+}
+
+bool ParameterScan::next(const ThePEG::EGPtr &eg)
+{
+	size_t next = current_ < points_.size() ? current_ + 1 : 0;
+	if (next >= points_.size())
+		return false;
+
+	current_ = next;
+	apply(eg, points_[current_]);
+	edm::LogInfo("Herwig7Interface") << "Scan point " << points_[current_].name << " (" << current_ + 1 << " of "
+					 << points_.size() << ") applied";
+	return true;
+}
+
+void ParameterScan::record(double xsec, double xsecErr)
+{
+	if (current_ >= points_.size())
+		return;
+	Point &point = points_[current_];
+	point.xsec = xsec;
+	point.xsecErr = xsecErr;
+	edm::LogInfo("Herwig7Interface") << "Scan point " << point.name << ": " << point.events << " events, "
+					 << xsec << " +- " << xsecErr << " pb";
+}
+
+void ParameterScan::summary() const
+{
+	ostringstream table;
+	table << "Parameter scan, cross section per point:";
+	for (vector<Point>::const_iterator it = points_.begin(); it != points_.end(); ++it)
+		table << "\n  " << it->name << ": " << it->events << " events, " << it->xsec << " +- " << it->xsecErr << " pb";
+	edm::LogInfo("Herwig7Interface") << table.str();
+}
@@ -0,0 +1,43 @@
+/** \class PartialUnweighter
+ *
+ *  Partial unweighting of weighted events
+ */
+
+#include <cmath>
+
+#include "GeneratorInterface/Herwig7Interface/interface/PartialUnweighter.h"
+
+PartialUnweighter::PartialUnweighter(double minWeight, double maxSpread) :
+	minWeight_(minWeight),
+	maxSpread_(maxSpread > 1. ? maxSpread : 1.),
+	maxWeight_(0.),
+	attempted_(0), kept_(0)
+{
+}
+
+double PartialUnweighter::threshold() const
+{
+	return minWeight_ > 0. ? minWeight_ : maxWeight_ / maxSpread_;
+}
+
+bool PartialUnweighter::accept(double &weight, double random)
+{
+	++attempted_;
+
+	// The threshold is fixed before the event is looked at, so the procedure stays unbiased
+	double wt = threshold();
+	double absWeight = std::fabs(weight);
+	if (absWeight > maxWeight_)
+		maxWeight_ = absWeight;
+
+	if (absWeight >= wt) {
+		++kept_;
+		return true;
+	}
+	if (random * wt >= absWeight)
+		return false;
+
+	weight = weight < 0. ? -wt : wt;
+	++kept_;
+	return true;
+}
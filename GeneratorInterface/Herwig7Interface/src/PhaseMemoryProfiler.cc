@@ -0,0 +1,174 @@
+/** \class PhaseMemoryProfiler
+ *
+ *  Memory accounting of the phases of the generation loop
+ */
+
+#include <algorithm>
+#include <climits>
+#include <sstream>
+
+#include <malloc.h>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/PhaseMemoryProfiler.h"
+#include "GeneratorInterface/Herwig7Interface/interface/ProcessInfo.h"
+
+using namespace std;
+
+PhaseMemoryProfiler::Scope::Scope(PhaseMemoryProfiler *profiler, const char *phase) :
+	profiler_(profiler), phase_(0), heap_(0), rss_(0)
+{
+	if (!profiler_)
+		return;
+	phase_ = profiler_->phase(phase);
+	rss_ = ProcessInfo::residentSetSize();
+	heap_ = liveHeap();
+	profiler_->enter(heap_, rss_);
+}
+
+PhaseMemoryProfiler::Scope::~Scope()
+{
+	if (!profiler_)
+		return;
+	long heap = liveHeap();
+	long rss = ProcessInfo::residentSetSize();
+	profiler_->account(phase_, heap - heap_, rss - rss_);
+	profiler_->lastHeap_ = heap;
+	profiler_->lastRss_ = rss;
+}
+
+PhaseMemoryProfiler::PhaseMemoryProfiler(unsigned int window, double growthThreshold) :
+	window_(window ? window : 1),
+	growthThreshold_(long(growthThreshold * 1024 * 1024)),
+	events_(0),
+	lastHeap_(-1),
+	lastRss_(-1),
+	windowMin_(LONG_MAX)
+{
+}
+
+long PhaseMemoryProfiler::liveHeap()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 heap = mallinfo2();
+	return long(heap.uordblks) + long(heap.hblkhd);
+#else
+	// The fields are ints, read them unsigned to get up to 4 GB right
+	struct mallinfo heap = mallinfo();
+	return long((unsigned int)heap.uordblks) + long((unsigned int)heap.hblkhd);
+#endif
+}
+
+size_t PhaseMemoryProfiler::phase(const char *name)
+{
+	map<string, size_t>::const_iterator it = phaseIndex_.find(name);
+	if (it != phaseIndex_.end())
+		return it->second;
+
+	Phase phase;
+	phase.name = name;
+	phase.calls = 0;
+	phase.heapDelta = phase.rssDelta = 0.;
+	phase.maxHeapDelta = phase.eventHeapDelta = phase.windowHeapDelta = 0;
+	phase.windows = phase.retainingWindows = 0;
+	phases_.push_back(phase);
+	phaseIndex_[name] = phases_.size() - 1;
+	return phases_.size() - 1;
+}
+
+void PhaseMemoryProfiler::enter(long heap, long rss)
+{
+	if (lastHeap_ >= 0)
+		account(phase("outside"), heap - lastHeap_, rss - lastRss_);
+}
+
+void PhaseMemoryProfiler::account(size_t index, long heapDelta, long rssDelta)
+{
+	Phase &phase = phases_[index];
+	++phase.calls;
+	phase.heapDelta += heapDelta;
+	phase.rssDelta += rssDelta;
+	phase.maxHeapDelta = max(phase.maxHeapDelta, heapDelta);
+	phase.eventHeapDelta += heapDelta;
+	phase.windowHeapDelta += heapDelta;
+}
+
+void PhaseMemoryProfiler::endEvent()
+{
+	++events_;
+	windowMin_ = min(windowMin_, liveHeap());
+	bool windowDone = events_ % window_ == 0;
+	if (windowDone) {
+		windowMins_.push_back(windowMin_);
+		windowMin_ = LONG_MAX;
+	}
+
+	ostringstream deltas;
+	for (vector<Phase>::iterator it = phases_.begin(); it != phases_.end(); ++it) {
+		deltas << " " << it->name << " " << it->eventHeapDelta;
+		it->eventHeapDelta = 0;
+		if (windowDone) {
+			++it->windows;
+			if (it->windowHeapDelta > 0)
+				++it->retainingWindows;
+			it->windowHeapDelta = 0;
+		}
+	}
+	LogDebug("Herwig7Interface") << "Live heap change per phase of event " << events_ << " [B]:" << deltas.str();
+}
+
+bool PhaseMemoryProfiler::jobGrowing() const
+{
+	if (windowMins_.size() < 3 || windowMins_.back() - windowMins_.front() < growthThreshold_)
+		return false;
+
+	// A cache filled once levels off, a leak keeps the minimum rising
+	size_t rises = 0;
+	for (size_t i = 1; i < windowMins_.size(); ++i)
+		if (windowMins_[i] > windowMins_[i - 1])
+			++rises;
+	return 4 * rises >= 3 * (windowMins_.size() - 1);
+}
+
+namespace {
+	struct ByHeapDelta {
+		bool operator () (const pair<double, size_t> &a, const pair<double, size_t> &b) const { return a.first > b.first; }
+	};
+}
+
+void PhaseMemoryProfiler::summary() const
+{
+	if (phases_.empty() || !events_)
+		return;
+
+	vector<pair<double, size_t> > ranking;
+	for (size_t i = 0; i < phases_.size(); ++i)
+		ranking.push_back(make_pair(phases_[i].heapDelta, i));
+	stable_sort(ranking.begin(), ranking.end(), ByHeapDelta());
+
+	bool growing = jobGrowing();
+	ostringstream table;
+	table << "Memory per phase in " << events_ << " events, ranked by the live heap retained:\n"
+	      << "  phase            calls   retained [kB]   mean heap [kB]   max heap [kB]   mean RSS [kB]   retaining windows";
+	unsigned int flagged = 0;
+	for (size_t i = 0; i < ranking.size(); ++i) {
+		const Phase &phase = phases_[ranking[i].second];
+		bool retains = growing && phase.windows > 1 && phase.heapDelta > 0. &&
+			4 * phase.retainingWindows >= 3 * phase.windows;
+		flagged += retains;
+		table << "\n  " << phase.name << string(phase.name.size() < 14 ? 14 - phase.name.size() : 1, ' ')
+		      << "   " << phase.calls
+		      << "   " << phase.heapDelta / 1024.
+		      << "   " << phase.heapDelta / phase.calls / 1024.
+		      << "   " << phase.maxHeapDelta / 1024.
+		      << "   " << phase.rssDelta / phase.calls / 1024.
+		      << "   " << phase.retainingWindows << "/" << phase.windows
+		      << (retains ? "   GROWING" : "");
+	}
+	edm::LogInfo("Herwig7Interface") << table.str();
+	if (growing)
+		edm::LogWarning("Herwig7Interface") << "The live heap grew by " << (windowMins_.back() - windowMins_.front()) / 1024.
+						    << " kB from the first to the last window of " << window_ << " events, "
+						    << flagged << " phases retain memory in most windows";
+}
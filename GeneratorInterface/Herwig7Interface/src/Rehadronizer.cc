@@ -0,0 +1,168 @@
+/** \class Rehadronizer
+ *
+ *  Re-hadronization of showered events with tune variations
+ */
+
+#include <sstream>
+
+#include <HepMC/IO_GenEvent.h>
+
+#include <ThePEG/Handlers/EventHandler.h>
+#include <ThePEG/Handlers/Hint.h>
+#include <ThePEG/Handlers/StepHandler.h>
+#include <ThePEG/EventRecord/Collision.h>
+#include <ThePEG/Interface/InterfaceBase.h>
+#include <ThePEG/Repository/BaseRepository.h>
+#include <ThePEG/Repository/CurrentGenerator.h>
+#include <ThePEG/Repository/StandardRandom.h>
+#include <ThePEG/Repository/UseRandom.h>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/CompactEventIO.h"
+#include "GeneratorInterface/Herwig7Interface/interface/ContentHash.h"
+#include "GeneratorInterface/Herwig7Interface/interface/Rehadronizer.h"
+
+using namespace std;
+
+Rehadronizer::Rehadronizer(const vector<edm::ParameterSet> &variations) :
+	jobSeed_(0)
+{
+	for (vector<edm::ParameterSet>::const_iterator it = variations.begin(); it != variations.end(); ++it) {
+		Variation variation;
+		variation.name = it->getUntrackedParameter<string>("name");
+		variation.failures = 0;
+
+		vector<string> commands = it->getUntrackedParameter<vector<string> >("commands");
+		for (vector<string>::const_iterator cmd = commands.begin(); cmd != commands.end(); ++cmd) {
+			Setting setting;
+			setting.interface = 0;
+			istringstream words(*cmd);
+			string verb, path;
+			words >> verb >> path;
+			getline(words >> ws, setting.value);
+			size_t colon = path.rfind(':');
+			if (verb != "set" || colon == string::npos || setting.value.empty())
+				throw cms::Exception("Herwig7Interface") << "Tune variation " << variation.name << ": cannot apply \""
+									 << *cmd << "\", only \"set object:interface value\" is supported" << endl;
+			setting.objectName = path.substr(0, colon);
+			setting.interfaceName = path.substr(colon + 1);
+			variation.settings.push_back(setting);
+		}
+
+		string dumpEvents = it->getUntrackedParameter<string>("dumpEvents");
+		if (it->getUntrackedParameter<string>("dumpEventsFormat", "compact") == "compact")
+			variation.output.reset(new CompactEventIO(dumpEvents, ios::out,
+				it->getUntrackedParameter<bool>("dumpEventsQuantize", false)));
+		else
+			variation.output.reset(new HepMC::IO_GenEvent(dumpEvents.c_str(), ios::out));
+
+		variations_.push_back(variation);
+	}
+}
+
+ThePEG::StepHdlPtr Rehadronizer::handler(const string &name)
+{
+	ThePEG::tEHPtr eh = eg_->eventHandler();
+	const ThePEG::InterfaceBase *interface = ThePEG::BaseRepository::FindInterface(eh, name);
+	if (!interface)
+		throw cms::Exception("Herwig7Interface") << "Event handler " << eh->fullName() << " has no " << name << endl;
+
+	string handlerName = interface->exec(*eh, "get", "");
+	ThePEG::StepHdlPtr handler = ThePEG::dynamic_ptr_cast<ThePEG::StepHdlPtr>(eg_->getPointer(handlerName));
+	// Without its own step the event handler stops after the shower
+	if (handler)
+		interface->exec(*eh, "set", "NULL");
+	return handler;
+}
+
+void Rehadronizer::init(const ThePEG::EGPtr &eg, long jobSeed)
+{
+	// A generator initialized again keeps its handlers taken out
+	if (eg == eg_)
+		return;
+	eg_ = eg;
+	jobSeed_ = jobSeed;
+
+	// The nominal hadronization continues the stream of the generator, as it would inside shoot()
+	const ThePEG::InterfaceBase *randomInterface = ThePEG::BaseRepository::FindInterface(eg_, "RandomNumberGenerator");
+	if (randomInterface)
+		random_ = ThePEG::dynamic_ptr_cast<ThePEG::RanGenPtr>(eg_->getPointer(randomInterface->exec(*eg_, "get", "")));
+	if (!random_)
+		throw cms::Exception("Herwig7Interface") << "Re-hadronization cannot find the random number generator of "
+							 << eg_->fullName() << endl;
+
+	hadronizationHandler_ = handler("HadronizationHandler");
+	decayHandler_ = handler("DecayHandler");
+	if (!hadronizationHandler_)
+		throw cms::Exception("Herwig7Interface") << "Re-hadronization needs a HadronizationHandler in "
+							 << eg_->eventHandler()->fullName() << endl;
+
+	for (vector<Variation>::iterator var = variations_.begin(); var != variations_.end(); ++var) {
+		for (vector<Setting>::iterator it = var->settings.begin(); it != var->settings.end(); ++it) {
+			it->object = eg_->getPointer(it->objectName);
+			if (it->object)
+				it->interface = ThePEG::BaseRepository::FindInterface(it->object, it->interfaceName);
+			if (!it->interface)
+				throw cms::Exception("Herwig7Interface") << "Tune variation " << var->name << ": " << it->objectName << ":"
+									 << it->interfaceName << " is not an interface of the run" << endl;
+			it->nominal = it->interface->exec(*it->object, "get", "");
+		}
+		edm::LogInfo("Herwig7Interface") << "Tune variation " << var->name << " with " << var->settings.size() << " settings";
+	}
+}
+
+void Rehadronizer::apply(vector<Setting> &settings, bool nominal)
+{
+	for (vector<Setting>::iterator it = settings.begin(); it != settings.end(); ++it)
+		it->interface->exec(*it->object, "set", nominal ? it->nominal : it->value);
+}
+
+bool Rehadronizer::performSteps(const ThePEG::EventPtr &event, const ThePEG::RanGenPtr &random)
+{
+	ThePEG::tEHPtr eh = eg_->eventHandler();
+	// Outside of shoot() the generator and its random generator have to be made current
+	ThePEG::CurrentGenerator currentGenerator(eg_);
+	ThePEG::UseRandom currentRandom(random);
+	try {
+		eh->currentEvent(event);
+		eh->currentCollision(event->primaryCollision());
+		eh->currentStep(event->primaryCollision()->finalStep());
+		eh->performStep(hadronizationHandler_, ThePEG::Hint::Default());
+		if (decayHandler_)
+			eh->performStep(decayHandler_, ThePEG::Hint::Default());
+	} catch (std::exception &exc) {
+		edm::LogWarning("Herwig7Interface") << "Hadronization of the showered event failed: " << exc.what();
+		return false;
+	}
+	return true;
+}
+
+bool Rehadronizer::hadronize(const ThePEG::EventPtr &event, size_t variation, long eventNumber)
+{
+	// Never drawn from the stream of the generator, which would change the nominal events
+	ContentHash hash;
+	hash.update(int64_t(jobSeed_)).update(int64_t(eventNumber)).update(int64_t(variation));
+	// Valid seeds of the RANMAR algorithm of StandardRandom
+	ThePEG::RanGenPtr random = ThePEG::new_ptr(ThePEG::StandardRandom());
+	random->setSeed(long(hash.value() % 900000000) + 1);
+
+	Variation &var = variations_[variation];
+	apply(var.settings, false);
+	bool hadronized = performSteps(event, random);
+	apply(var.settings, true);
+	if (!hadronized)
+		++var.failures;
+	return hadronized;
+}
+
+bool Rehadronizer::hadronize(const ThePEG::EventPtr &event)
+{
+	return performSteps(event, random_);
+}
+
+void Rehadronizer::write(size_t variation, const HepMC::GenEvent &event)
+{
+	variations_[variation].output->write_event(&event);
+}
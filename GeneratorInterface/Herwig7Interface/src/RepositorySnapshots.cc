@@ -0,0 +1,188 @@
+/** \class RepositorySnapshots
+ *
+ *  Prefix snapshots of the repository for the read step
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/ContentHash.h"
+#include "GeneratorInterface/Herwig7Interface/interface/RepositorySnapshots.h"
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace {
+	// Repository directory after a cd to dir
+	string resolveDirectory(string cwd, const string &dir)
+	{
+		if (dir[0] == '/')
+			cwd = "/";
+		istringstream parts(dir);
+		string part;
+		while (getline(parts, part, '/')) {
+			if (part.empty() || part == ".")
+				continue;
+			if (part == "..")
+				cwd = cwd.size() > 1 ? cwd.substr(0, cwd.rfind('/', cwd.size() - 2) + 1) : cwd;
+			else
+				cwd += part + "/";
+		}
+		return cwd;
+	}
+
+	// File a read command refers to, the directory of the reading file is searched first
+	string findFile(const string &name, const string &fileDirectory, const vector<string> &readDirectories)
+	{
+		boost::system::error_code ec;
+		if (name[0] == '/')
+			return fs::is_regular_file(name, ec) ? name : string();
+		if (!fileDirectory.empty() && fs::is_regular_file(fs::path(fileDirectory) / name, ec))
+			return (fs::path(fileDirectory) / name).string();
+		for (vector<string>::const_iterator dir = readDirectories.begin(); dir != readDirectories.end(); ++dir)
+			if (fs::is_regular_file(fs::path(*dir) / name, ec))
+				return (fs::path(*dir) / name).string();
+		return string();
+	}
+
+	// Follow the commands through nested read files like the repository,
+	// hashing the files read and keeping the directory stack up to date
+	bool follow(const string &commands, const string &fileDirectory, const vector<string> &readDirectories,
+	            vector<string> &dirs, ContentHash &hash, unsigned int depth)
+	{
+		istringstream lines(commands);
+		string line;
+		while (getline(lines, line)) {
+			istringstream words(line);
+			string verb, arg;
+			if (!(words >> verb) || verb[0] == '#')
+				continue;
+			words >> arg;
+			if (verb == "cd" && !arg.empty())
+				dirs.back() = resolveDirectory(dirs.back(), arg);
+			else if (verb == "pushd" && !arg.empty())
+				dirs.push_back(resolveDirectory(dirs.back(), arg));
+			else if (verb == "popd" && dirs.size() > 1)
+				dirs.pop_back();
+			else if (verb == "load")
+				return false;
+			else if (verb == "read") {
+				string file = arg.empty() || depth > 32 ? string() : findFile(arg, fileDirectory, readDirectories);
+				if (file.empty())
+					return false;
+				ifstream in(file.c_str());
+				ostringstream content;
+				content << in.rdbuf();
+				hash.update(file).update(content.str());
+				if (!follow(content.str(), fs::path(file).parent_path().string(), readDirectories, dirs, hash, depth + 1))
+					return false;
+			}
+		}
+		return true;
+	}
+}
+
+RepositorySnapshots::RepositorySnapshots(const string &directory, const string &repository,
+                                         const vector<string> &readDirectories) :
+	directory_(directory),
+	repository_(repository),
+	readDirectories_(readDirectories),
+	start_(repository),
+	restored_(0)
+{
+}
+
+RepositorySnapshots::~RepositorySnapshots()
+{
+	// Left by a failed step
+	for (vector<string>::const_iterator it = pending_.begin(); it != pending_.end(); ++it) {
+		boost::system::error_code ec;
+		fs::remove(*it, ec);
+	}
+}
+
+string RepositorySnapshots::path(size_t block) const
+{
+	return (fs::path(directory_) / (keys_[block] + ".rpo")).string();
+}
+
+void RepositorySnapshots::addBlock(const string &commands)
+{
+	blocks_.push_back(commands);
+	// Blocks after one that could not be followed are replayed every time
+	if (keys_.size() + 1 < blocks_.size())
+		return;
+
+	ContentHash hash;
+	if (keys_.empty()) {
+		hash.update(repository_);
+		hash.updateFile(repository_);
+	} else {
+		hash.update(keys_.back());
+	}
+	hash.update(commands);
+
+	vector<string> dirs = dirs_.empty() ? vector<string>(1, "/") : dirs_.back();
+	if (!follow(commands, "", readDirectories_, dirs, hash, 0)) {
+		edm::LogWarning("Herwig7Interface") << "Repository snapshots end after " << keys_.size()
+						    << " command blocks, block " << blocks_.size()
+						    << " reads a file which cannot be followed";
+		return;
+	}
+	keys_.push_back(hash.hex());
+	dirs_.push_back(dirs);
+}
+
+string RepositorySnapshots::input()
+{
+	start_ = repository_;
+	restored_ = 0;
+	for (size_t i = keys_.size(); i > 0; --i) {
+		if (fs::exists(path(i - 1))) {
+			start_ = path(i - 1);
+			restored_ = i;
+			break;
+		}
+	}
+
+	fs::create_directories(directory_);
+	ostringstream input;
+	if (restored_) {
+		const vector<string> &dirs = dirs_[restored_ - 1];
+		input << "# Restored from snapshot " << start_ << " after " << restored_ << " blocks" << endl
+		      << "cd " << dirs[0] << endl;
+		for (size_t i = 1; i < dirs.size(); ++i)
+			input << "pushd " << dirs[i] << endl;
+	}
+	for (size_t i = restored_; i < blocks_.size(); ++i) {
+		input << blocks_[i] << endl;
+		if (i >= keys_.size())
+			continue;
+		ostringstream tmpName;
+		tmpName << path(i) << ".tmp" << getpid();
+		pending_.push_back(tmpName.str());
+		input << "save " << tmpName.str() << endl;
+	}
+	return input.str();
+}
+
+size_t RepositorySnapshots::commit()
+{
+	size_t committed = 0;
+	for (vector<string>::const_iterator it = pending_.begin(); it != pending_.end(); ++it) {
+		boost::system::error_code ec;
+		if (!fs::exists(*it, ec))
+			continue;
+		fs::rename(*it, it->substr(0, it->rfind(".tmp")), ec);
+		if (!ec)
+			++committed;
+	}
+	pending_.clear();
+	return committed;
+}
@@ -0,0 +1,94 @@
+/** \class RunFilePruner
+ *
+ *  Reachability analysis of the objects in a run file
+ */
+
+#include <deque>
+
+#include <boost/filesystem.hpp>
+
+#include <ThePEG/Config/ThePEG.h>
+#include <ThePEG/Repository/BaseRepository.h>
+#include <ThePEG/Repository/EventGenerator.h>
+#include <ThePEG/Persistency/PersistentIStream.h>
+#include <ThePEG/PDT/ParticleData.h>
+#include <ThePEG/PDT/DecayMode.h>
+#include <ThePEG/PDT/Decayer.h>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/ProcessInfo.h"
+#include "GeneratorInterface/Herwig7Interface/interface/RunFilePruner.h"
+
+using namespace std;
+
+RunFilePruner::RunFilePruner(const string &runFile) :
+	runFile_(runFile),
+	stored_(0), reachable_(0), loadedMemory_(0)
+{
+}
+
+long RunFilePruner::fileSize() const
+{
+	boost::system::error_code ec;
+	boost::uintmax_t size = boost::filesystem::file_size(runFile_, ec);
+	return ec ? -1 : long(size);
+}
+
+bool RunFilePruner::analyse()
+{
+	removable_.clear();
+
+	long rssBefore = ProcessInfo::residentSetSize();
+	ThePEG::EGPtr eg;
+	try {
+		ThePEG::PersistentIStream is(runFile_);
+		is >> eg;
+	}
+	catch ( ThePEG::Exception & e ) {
+		edm::LogWarning("Herwig7Interface") << "Could not load " << runFile_ << ": " << e.what();
+		return false;
+	}
+	if (!eg)
+		return false;
+	loadedMemory_ = ProcessInfo::residentSetSize() - rssBefore;
+
+	// Breadth-first walk over the interface references starting at the generator
+	ThePEG::ObjectSet reached;
+	deque<ThePEG::IBPtr> toVisit(1, eg);
+	reached.insert(eg);
+	while (!toVisit.empty()) {
+		ThePEG::IBPtr obj = toVisit.front();
+		toVisit.pop_front();
+		ThePEG::ObjectSet refs = ThePEG::BaseRepository::DirectReferences(obj);
+		for (ThePEG::ObjectSet::const_iterator it = refs.begin(); it != refs.end(); ++it)
+			if (*it && reached.insert(*it).second)
+				toVisit.push_back(*it);
+	}
+
+	const ThePEG::ObjectSet &objects = eg->objects();
+	stored_ = objects.size();
+	reachable_ = 0;
+	for (ThePEG::ObjectSet::const_iterator it = objects.begin(); it != objects.end(); ++it) {
+		if (reached.count(*it)) {
+			++reachable_;
+			continue;
+		}
+		const ThePEG::InterfacedBase *obj = &**it;
+		if (dynamic_cast<const ThePEG::ParticleData *>(obj) ||
+		    dynamic_cast<const ThePEG::DecayMode *>(obj) ||
+		    dynamic_cast<const ThePEG::Decayer *>(obj))
+			continue;
+		removable_.push_back(obj->fullName());
+	}
+
+	return true;
+}
+
+string RunFilePruner::removeCommand() const
+{
+	string command;
+	for (vector<string>::const_iterator it = removable_.begin(); it != removable_.end(); ++it)
+		command += (command.empty() ? "rm " : " ") + *it;
+	return command;
+}
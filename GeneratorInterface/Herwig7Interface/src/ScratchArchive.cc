@@ -0,0 +1,216 @@
+/** \class ScratchArchive
+ *
+ *  Indexed single-file archive of Herwig-scratch
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/ScratchArchive.h"
+
+using namespace std;
+
+namespace {
+	const char archiveMagic[4] = { 'H', '7', 'S', 'A' };
+	const char indexMagic[4] = { 'H', '7', 'S', 'I' };
+	const uint32_t formatVersion = 1;
+	const size_t headerSize = sizeof(archiveMagic) + sizeof(uint32_t);
+	const size_t footerSize = sizeof(uint64_t) + sizeof(indexMagic);
+
+	template<typename T>
+	inline void writeRaw(ofstream &out, T value) { out.write(reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+	// Reads a value from the mapping, false if it would run past its end
+	template<typename T>
+	inline bool readRaw(const char *data, size_t length, size_t &pos, T &value)
+	{
+		if (pos + sizeof(value) > length)
+			return false;
+		memcpy(&value, data + pos, sizeof(value));
+		pos += sizeof(value);
+		return true;
+	}
+}
+
+size_t ScratchArchive::pack(const string &directory, const string &archive)
+{
+	namespace fs = boost::filesystem;
+
+	vector<Entry> entries;
+	ostringstream tmpName;
+	tmpName << archive << ".tmp" << getpid();
+	ofstream out(tmpName.str().c_str(), ios::out | ios::binary | ios::trunc);
+	out.write(archiveMagic, sizeof(archiveMagic));
+	writeRaw(out, formatVersion);
+
+	size_t prefix = fs::path(directory).string().size() + 1;
+	vector<char> buffer(1 << 20);
+	// Links are followed and their targets stored as files: the matrix element
+	// cache links its libraries into the scratch directory with absolute paths,
+	// which do not exist where the archive is extracted
+	for (fs::recursive_directory_iterator it(directory, fs::symlink_option::recurse), end; it != end; ++it) {
+		boost::system::error_code ec;
+		fs::file_status status = it->status(ec);
+		if (!fs::is_regular_file(status)) {
+			if (fs::is_symlink(it->symlink_status(ec)) && !fs::exists(status))
+				edm::LogWarning("Herwig7Interface") << "Dangling link " << it->path().string() << " not packed";
+			continue;
+		}
+
+		Entry entry;
+		entry.path = it->path().string().substr(prefix);
+		entry.type = File;
+		entry.mode = status.permissions();
+		entry.offset = out.tellp();
+		entry.size = 0;
+		ifstream in(it->path().string().c_str(), ios::in | ios::binary);
+		while (in.read(&buffer[0], buffer.size()) || in.gcount()) {
+			out.write(&buffer[0], in.gcount());
+			entry.size += in.gcount();
+		}
+		entries.push_back(entry);
+	}
+
+	uint64_t indexOffset = out.tellp();
+	writeRaw<uint64_t>(out, entries.size());
+	for (vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		writeRaw<uint32_t>(out, it->path.size());
+		out.write(it->path.data(), it->path.size());
+		writeRaw(out, it->type);
+		writeRaw(out, it->mode);
+		writeRaw(out, it->offset);
+		writeRaw(out, it->size);
+	}
+	writeRaw(out, indexOffset);
+	out.write(indexMagic, sizeof(indexMagic));
+	out.close();
+	if (!out)
+		throw runtime_error("ScratchArchive: cannot write " + tmpName.str());
+
+	fs::rename(tmpName.str(), archive);
+	return entries.size();
+}
+
+ScratchArchive::ScratchArchive(const string &archive) :
+	archive_(archive),
+	data_(0),
+	length_(0)
+{
+	int fd = open(archive.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && size_t(st.st_size) >= headerSize + footerSize) {
+		void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			data_ = static_cast<const char *>(map);
+			length_ = st.st_size;
+		}
+	}
+	close(fd);
+
+	if (data_ && !readIndex()) {
+		edm::LogWarning("Herwig7Interface") << "Scratch archive " << archive << " is corrupt, ignoring it";
+		munmap(const_cast<char *>(data_), length_);
+		data_ = 0;
+		entries_.clear();
+	}
+}
+
+ScratchArchive::~ScratchArchive()
+{
+	if (data_)
+		munmap(const_cast<char *>(data_), length_);
+}
+
+bool ScratchArchive::readIndex()
+{
+	uint32_t version;
+	size_t pos = sizeof(archiveMagic);
+	if (memcmp(data_, archiveMagic, sizeof(archiveMagic)) || !readRaw(data_, length_, pos, version) || version != formatVersion)
+		return false;
+
+	uint64_t indexOffset;
+	pos = length_ - footerSize;
+	if (!readRaw(data_, length_, pos, indexOffset) || memcmp(data_ + pos, indexMagic, sizeof(indexMagic)))
+		return false;
+
+	uint64_t count;
+	pos = indexOffset;
+	if (!readRaw(data_, length_, pos, count))
+		return false;
+	entries_.resize(count);
+	for (uint64_t i = 0; i < count; ++i) {
+		Entry &entry = entries_[i];
+		uint32_t pathLength;
+		if (!readRaw(data_, length_, pos, pathLength) || pos + pathLength > length_)
+			return false;
+		entry.path.assign(data_ + pos, pathLength);
+		pos += pathLength;
+		if (!readRaw(data_, length_, pos, entry.type) || !readRaw(data_, length_, pos, entry.mode) ||
+		    !readRaw(data_, length_, pos, entry.offset) || !readRaw(data_, length_, pos, entry.size) ||
+		    entry.offset + entry.size > indexOffset)
+			return false;
+	}
+	sort(entries_.begin(), entries_.end());
+	return true;
+}
+
+bool ScratchArchive::extract(const string &directory, const Entry &entry) const
+{
+	namespace fs = boost::filesystem;
+
+	fs::path target = fs::path(directory) / entry.path;
+	boost::system::error_code ec;
+	if (fs::exists(fs::symlink_status(target, ec)))
+		return false;
+	fs::create_directories(target.parent_path());
+
+	// Written under a temporary name, so concurrent jobs never see a partial file
+	ostringstream tmpName;
+	tmpName << target.string() << ".tmp" << getpid();
+	if (entry.type == Link) {
+		fs::create_symlink(string(data_ + entry.offset, entry.size), tmpName.str());
+	} else {
+		ofstream out(tmpName.str().c_str(), ios::out | ios::binary | ios::trunc);
+		out.write(data_ + entry.offset, entry.size);
+		out.close();
+		if (!out)
+			throw runtime_error("ScratchArchive: cannot write " + tmpName.str());
+		chmod(tmpName.str().c_str(), entry.mode & 07777);
+	}
+	fs::rename(tmpName.str(), target);
+	return true;
+}
+
+size_t ScratchArchive::extract(const string &directory, const vector<string> &prefixes,
+                               const vector<string> &excluded) const
+{
+	size_t extracted = 0;
+	for (vector<string>::const_iterator prefix = prefixes.begin(); prefix != prefixes.end(); ++prefix) {
+		Entry key;
+		key.path = *prefix;
+		for (vector<Entry>::const_iterator it = lower_bound(entries_.begin(), entries_.end(), key);
+		     it != entries_.end() && it->path.compare(0, prefix->size(), *prefix) == 0; ++it) {
+			bool skip = false;
+			for (vector<string>::const_iterator ex = excluded.begin(); ex != excluded.end() && !skip; ++ex)
+				skip = it->path.compare(0, ex->size(), *ex) == 0;
+			if (!skip && extract(directory, *it))
+				++extracted;
+		}
+	}
+	return extracted;
+}
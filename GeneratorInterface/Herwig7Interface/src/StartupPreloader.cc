@@ -0,0 +1,175 @@
+/** \class StartupPreloader
+ *
+ *  Parallel prefetching of the files needed at startup
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <link.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/StartupPreloader.h"
+
+using namespace std;
+
+StartupPreloader::StartupPreloader(const string &manifest, unsigned int threads) :
+	manifest_(manifest),
+	threads_(threads ? threads : 1),
+	initialFiles_(mappedFiles()),
+	manifestRead_(false),
+	preloaded_(false)
+{
+}
+
+set<string> StartupPreloader::mappedFiles()
+{
+	set<string> files;
+	ifstream maps("/proc/self/maps");
+	string line;
+	while (getline(maps, line)) {
+		size_t pos = line.find('/');
+		if (pos == string::npos)
+			continue;
+		string fileName = line.substr(pos);
+		if (fileName.find(" (deleted)") != string::npos)
+			continue;
+		files.insert(fileName);
+	}
+	return files;
+}
+
+namespace {
+	int addLibrary(struct dl_phdr_info *info, size_t, void *data)
+	{
+		// The executable and the vDSO have no file name
+		if (info->dlpi_name && *info->dlpi_name) {
+			boost::system::error_code ec;
+			boost::filesystem::path path = boost::filesystem::canonical(info->dlpi_name, ec);
+			if (!ec)
+				static_cast<vector<string> *>(data)->push_back(path.string());
+		}
+		return 0;
+	}
+}
+
+vector<string> StartupPreloader::loadedLibraries()
+{
+	// The link map lists the libraries in the order they were loaded
+	vector<string> libraries;
+	dl_iterate_phdr(addLibrary, &libraries);
+	return libraries;
+}
+
+void StartupPreloader::addFile(const string &fileName)
+{
+	if (boost::filesystem::exists(fileName))
+		extraFiles_.insert(boost::filesystem::absolute(fileName).string());
+}
+
+void StartupPreloader::prefetchFiles(const vector<string> *files, size_t first, size_t step)
+{
+	vector<char> buffer(1 << 20);
+	for (size_t i = first; i < files->size(); i += step) {
+		int fd = open((*files)[i].c_str(), O_RDONLY);
+		if (fd < 0)
+			continue;
+		posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+		while (read(fd, &buffer[0], buffer.size()) > 0)
+			;
+		close(fd);
+	}
+}
+
+void StartupPreloader::readManifest()
+{
+	if (manifestRead_)
+		return;
+	manifestRead_ = true;
+	ifstream in(manifest_.c_str());
+	// One "<kind> <path>" per line, the path runs to the end of the line
+	string line;
+	while (getline(in, line)) {
+		size_t pos = line.find(' ');
+		if (pos == string::npos || pos + 1 == line.size())
+			continue;
+		string fileName = line.substr(pos + 1);
+		files_.push_back(fileName);
+		if (line.compare(0, pos, "lib") == 0)
+			libraries_.push_back(fileName);
+	}
+}
+
+void StartupPreloader::prefetch()
+{
+	readManifest();
+	if (files_.empty())
+		return;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	boost::thread_group threads;
+	for (unsigned int i = 0; i < threads_; ++i)
+		threads.create_thread(boost::bind(&StartupPreloader::prefetchFiles, &files_, i, threads_));
+	threads.join_all();
+	edm::LogInfo("Herwig7Interface") << "Startup phase prefetch: " << files_.size() << " files in "
+					 << chrono::duration<double>(chrono::steady_clock::now() - start).count()
+					 << " s with " << threads_ << " threads";
+}
+
+void StartupPreloader::preload()
+{
+	readManifest();
+	if (preloaded_ || libraries_.empty())
+		return;
+	preloaded_ = true;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (size_t i = 0; i < libraries_.size(); ++i) {
+		void *handle = dlopen(libraries_[i].c_str(), RTLD_LAZY | RTLD_GLOBAL);
+		if (handle)
+			handles_.push_back(handle);
+		else
+			LogDebug("Herwig7Interface") << "Could not preload " << libraries_[i] << ": " << dlerror();
+	}
+	edm::LogInfo("Herwig7Interface") << "Startup phase preload: " << handles_.size() << " of " << libraries_.size()
+					 << " libraries in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s";
+}
+
+void StartupPreloader::record()
+{
+	vector<string> libraries = loadedLibraries();
+	set<string> files = mappedFiles();
+	files.insert(extraFiles_.begin(), extraFiles_.end());
+
+	string tmpName = manifest_ + ".tmp";
+	size_t count = 0;
+	{
+		ofstream out(tmpName.c_str(), ios_base::trunc);
+		// Libraries first, in load order
+		for (vector<string>::const_iterator it = libraries.begin(); it != libraries.end(); ++it) {
+			files.erase(*it);
+			if (initialFiles_.count(*it))
+				continue;
+			out << "lib " << *it << "\n";
+			++count;
+		}
+		// Further mapped files are only prefetched
+		for (set<string>::const_iterator it = files.begin(); it != files.end(); ++it) {
+			if (initialFiles_.count(*it) && !extraFiles_.count(*it))
+				continue;
+			out << "file " << *it << "\n";
+			++count;
+		}
+	}
+	rename(tmpName.c_str(), manifest_.c_str());
+	edm::LogInfo("Herwig7Interface") << "Startup manifest " << manifest_ << " written with " << count << " files";
+}
@@ -0,0 +1,87 @@
+/** \class ThroughputMonitor
+ *
+ *  Metrics export for long generation jobs
+ */
+
+#include <cstdio>
+#include <fstream>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "GeneratorInterface/Herwig7Interface/interface/ProcessInfo.h"
+#include "GeneratorInterface/Herwig7Interface/interface/ThroughputMonitor.h"
+
+using namespace std;
+
+ThroughputMonitor::ThroughputMonitor(const string &fileName, double interval, unsigned long long expectedEvents) :
+	fileName_(fileName),
+	interval_(chrono::duration_cast<Clock::duration>(chrono::duration<double>(interval))),
+	expectedEvents_(expectedEvents),
+	start_(Clock::now()),
+	last_(start_),
+	generating_(false),
+	generationStart_(start_),
+	lastEvent_(start_),
+	accepted_(0), failed_(0), lastAccepted_(0),
+	xsec_(-1.0), xsecErr_(-1.0)
+{
+}
+
+ThroughputMonitor::~ThroughputMonitor()
+{
+	write();
+}
+
+void ThroughputMonitor::startGeneration()
+{
+	if (generating_)
+		return;
+	generating_ = true;
+	generationStart_ = lastEvent_ = Clock::now();
+}
+
+bool ThroughputMonitor::due() const
+{
+	return Clock::now() - last_ >= interval_;
+}
+
+void ThroughputMonitor::write()
+{
+	Clock::time_point now = Clock::now();
+	double elapsed = chrono::duration<double>(now - last_).count();
+	double total = chrono::duration<double>(now - start_).count();
+
+	string tmpName = fileName_ + ".tmp";
+	{
+		ofstream out(tmpName.c_str(), ios_base::trunc);
+		out << "# TYPE herwig7_events_total counter\n"
+		    << "herwig7_events_total " << accepted_ << "\n"
+		    << "# TYPE herwig7_shoot_failures_total counter\n"
+		    << "herwig7_shoot_failures_total " << failed_ << "\n"
+		    << "# TYPE herwig7_events_per_second gauge\n"
+		    << "herwig7_events_per_second " << (elapsed > 0. ? (accepted_ - lastAccepted_) / elapsed : 0.) << "\n";
+		if (xsec_ >= 0.) {
+			out << "# TYPE herwig7_cross_section_pb gauge\n"
+			    << "herwig7_cross_section_pb " << xsec_ << "\n"
+			    << "# TYPE herwig7_cross_section_error_pb gauge\n"
+			    << "herwig7_cross_section_error_pb " << xsecErr_ << "\n";
+		}
+		out << "# TYPE herwig7_resident_memory_bytes gauge\n"
+		    << "herwig7_resident_memory_bytes " << ProcessInfo::residentSetSize() << "\n"
+		    << "# TYPE herwig7_uptime_seconds gauge\n"
+		    << "herwig7_uptime_seconds " << total << "\n";
+		if (generating_)
+			out << "# TYPE herwig7_generation_seconds gauge\n"
+			    << "herwig7_generation_seconds " << chrono::duration<double>(lastEvent_ - generationStart_).count() << "\n";
+		if (expectedEvents_ && accepted_) {
+			double remaining = expectedEvents_ > accepted_ ? double(expectedEvents_ - accepted_) : 0.;
+			out << "# TYPE herwig7_eta_seconds gauge\n"
+			    << "herwig7_eta_seconds " << remaining * total / accepted_ << "\n";
+		}
+	}
+	if (rename(tmpName.c_str(), fileName_.c_str()) != 0)
+		edm::LogWarning("Herwig7Interface") << "Could not write metrics file " << fileName_;
+
+	last_ = now;
+	lastAccepted_ = accepted_;
+}
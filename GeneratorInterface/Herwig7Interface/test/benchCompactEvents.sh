@@ -0,0 +1,15 @@
+#!/bin/sh
+
+# Size and speed of compact event files against HepMC ascii, on LEP events
+# (LEP.in) and on ttbar events. The bench mode of herwig7CompactEvents
+# writes and reads each sample in all formats, including the conversion
+# from and to HepMC.
+
+EVENTS=${EVENTS:-1000}
+LEP_IN=${LEP_IN:-../../../LEP.in}
+
+for SAMPLE in lep ttbar; do
+	cmsRun testCompactEvents_cfg.py sample=$SAMPLE maxEvents=$EVENTS lepConfig=$LEP_IN dumpEvents=$SAMPLE.hepmc || exit 1
+	echo "$SAMPLE, $EVENTS events:"
+	herwig7CompactEvents bench $SAMPLE.hepmc || exit 1
+done
@@ -0,0 +1,21 @@
+#!/bin/sh
+
+# Throughput of the minimum bias library mode against the usual generation
+# of EDM events from the same run file. The rates are taken from the event
+# loop in the metrics files, without the initialization. Finally the library
+# is read back into EDM events with Herwig7LibrarySource.
+
+EVENTS=${EVENTS:-10000}
+BATCH=${BATCH:-100}
+
+rate() {
+	awk '/^herwig7_events_total /{n=$2} /^herwig7_generation_seconds /{t=$2} END{if (t > 0) printf "%.1f", n/t; else print "n/a"}' $1
+}
+
+cmsRun testMinimumBiasLibrary_cfg.py runModeList=read || exit 1
+cmsRun testMinimumBiasLibrary_cfg.py runModeList=run mode=events maxEvents=$EVENTS metrics=events.metrics || exit 1
+cmsRun testMinimumBiasLibrary_cfg.py runModeList=run mode=library maxEvents=$((EVENTS / BATCH)) batchSize=$BATCH metrics=library.metrics || exit 1
+cmsRun testMinimumBiasLibrarySource_cfg.py library=library.h7ce || exit 1
+
+echo "EDM events:    $(rate events.metrics) events/s"
+echo "library mode:  $(rate library.metrics) events/s"
@@ -0,0 +1,67 @@
+import FWCore.ParameterSet.Config as cms
+from FWCore.ParameterSet.VarParsing import VarParsing
+
+# QCD events analysed in-process by the example analysis plugin
+# Herwig7MultiplicityAnalysis, without writing an event file. Two instances
+# with different cuts run on analysisThreads worker threads.
+
+options = VarParsing('analysis')
+options.register('threads', 0, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+	"Analysis threads, 0 runs the analyses in the generator thread")
+options.maxEvents = 100
+options.parseArguments()
+
+process = cms.Process("TEST")
+process.load("FWCore.Framework.test.cmsExceptionsFatal_cff")
+
+process.RandomNumberGeneratorService = cms.Service("RandomNumberGeneratorService",
+    generator = cms.PSet(
+        initialSeed = cms.untracked.uint32(123456789),
+    )
+)
+
+process.MessageLogger = cms.Service("MessageLogger",
+    cout = cms.untracked.PSet(
+        default = cms.untracked.PSet(
+            limit = cms.untracked.int32(2)
+        )
+    ),
+    destinations = cms.untracked.vstring('cout')
+)
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+process.source = cms.Source("EmptySource")
+
+from GeneratorInterface.Herwig7Interface.herwigValidation_cff import herwigValidationBlock
+process.load('Configuration.Generator.HerwigppDefaults_cfi')
+
+process.generator = cms.EDFilter("Herwig7GeneratorFilter",
+	process.herwigDefaultsBlock,
+
+	configFiles = cms.vstring(),
+
+	validationQCD = herwigValidationBlock.validationQCD,
+
+	parameterSets = cms.vstring(
+		'cmsDefaults',
+		'validationQCD'
+	),
+
+	analyses = cms.untracked.VPSet(
+		cms.PSet(
+			type = cms.untracked.string('Herwig7MultiplicityAnalysis'),
+			fileName = cms.untracked.string('multiplicity.txt'),
+		),
+		cms.PSet(
+			type = cms.untracked.string('Herwig7MultiplicityAnalysis'),
+			fileName = cms.untracked.string('multiplicity_central.txt'),
+			ptMin = cms.untracked.double(0.5),
+			etaMax = cms.untracked.double(2.5),
+		),
+	),
+	analysisThreads = cms.untracked.uint32(options.threads),
+)
+
+process.p = cms.Path(process.generator)
+process.schedule = cms.Schedule(process.p)
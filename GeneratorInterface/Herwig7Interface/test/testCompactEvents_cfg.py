@@ -0,0 +1,68 @@
+import FWCore.ParameterSet.Config as cms
+from FWCore.ParameterSet.VarParsing import VarParsing
+
+# LEP (LEP.in) or ttbar events dumped as HepMC ascii, the input of the bench
+# mode of herwig7CompactEvents in benchCompactEvents.sh.
+
+options = VarParsing('analysis')
+options.register('sample', 'lep', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"lep: e+e- -> q qbar at 91.2 GeV from LEP.in, ttbar: top pairs at the LHC")
+options.register('lepConfig', '../../../LEP.in', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"Herwig input file of the lep sample")
+options.register('dumpEvents', 'lep.hepmc', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"HepMC ascii output file")
+options.maxEvents = 1000
+options.parseArguments()
+
+process = cms.Process("GEN")
+process.load("FWCore.Framework.test.cmsExceptionsFatal_cff")
+
+process.RandomNumberGeneratorService = cms.Service("RandomNumberGeneratorService",
+    generator = cms.PSet(
+        initialSeed = cms.untracked.uint32(123456789),
+    )
+)
+
+process.MessageLogger = cms.Service("MessageLogger",
+    cout = cms.untracked.PSet(
+        default = cms.untracked.PSet(
+            limit = cms.untracked.int32(2)
+        )
+    ),
+    destinations = cms.untracked.vstring('cout')
+)
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+process.source = cms.Source("EmptySource")
+
+process.load('Configuration.Generator.HerwigppDefaults_cfi')
+
+process.generator = cms.EDFilter("Herwig7GeneratorFilter",
+	process.herwigDefaultsBlock,
+
+	configFiles = cms.vstring(),
+
+	ttbar = cms.vstring(
+		'cd /Herwig/MatrixElements/',
+		'insert SimpleQCD:MatrixElements[0] MEHeavyQuark',
+		'cd /',
+	),
+
+	parameterSets = cms.vstring(
+		'cmsDefaults',
+		'ttbar'
+	),
+
+	dumpEvents = cms.untracked.string(options.dumpEvents),
+	dumpEventsFormat = cms.untracked.string('ascii'),
+)
+
+if options.sample == 'lep':
+	process.generator.configFiles = cms.vstring(options.lepConfig)
+	process.generator.parameterSets = cms.vstring()
+	process.generator.generatorModule = cms.string('/Herwig/Generators/LEPGenerator')
+	process.generator.run = cms.string('LEP')
+
+process.p = cms.Path(process.generator)
+process.schedule = cms.Schedule(process.p)
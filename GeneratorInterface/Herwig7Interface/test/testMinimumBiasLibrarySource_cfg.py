@@ -0,0 +1,31 @@
+import FWCore.ParameterSet.Config as cms
+from FWCore.ParameterSet.VarParsing import VarParsing
+
+# Generator events read from a minimum bias library, the input of the
+# simulation of a pileup sample. Later steps take the HepMCProduct from
+# the source instead of the generator, e.g.
+#   process.VtxSmeared.src = cms.InputTag("source", "unsmeared")
+
+options = VarParsing('analysis')
+options.register('library', 'library.h7ce', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"Minimum bias library written by testMinimumBiasLibrary_cfg.py mode=library")
+options.register('firstEvent', 0, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+	"First library event of this job")
+options.outputFile = 'library.root'
+options.parseArguments()
+
+process = cms.Process("LIB")
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+process.source = cms.Source("Herwig7LibrarySource",
+	fileName = cms.untracked.string(options.library),
+	firstEvent = cms.untracked.uint32(options.firstEvent),
+)
+
+process.GEN = cms.OutputModule("PoolOutputModule",
+	fileName = cms.untracked.string(options.outputFile)
+)
+
+process.outpath = cms.EndPath(process.GEN)
+process.schedule = cms.Schedule(process.outpath)
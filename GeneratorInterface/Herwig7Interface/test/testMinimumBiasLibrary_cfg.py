@@ -0,0 +1,80 @@
+import FWCore.ParameterSet.Config as cms
+from FWCore.ParameterSet.VarParsing import VarParsing
+
+# Minimum bias events from the same run file, either generated as usual into
+# an EDM file or written in batches to a minimum bias library. The throughput
+# of both is compared by benchMinimumBiasLibrary.sh.
+
+options = VarParsing('analysis')
+options.register('mode', 'events', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"events: EDM events as usual, library: batches of final states into library.h7ce")
+options.register('runModeList', 'read,run', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"Herwig steps of this job")
+options.register('batchSize', 100, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+	"Library events per framework event")
+options.register('metrics', 'events.metrics', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"Metrics file, holding the duration of the event loop")
+options.maxEvents = 1000
+options.parseArguments()
+
+process = cms.Process("GEN")
+process.load("FWCore.Framework.test.cmsExceptionsFatal_cff")
+
+process.RandomNumberGeneratorService = cms.Service("RandomNumberGeneratorService",
+    generator = cms.PSet(
+        initialSeed = cms.untracked.uint32(123456789),
+    )
+)
+
+process.MessageLogger = cms.Service("MessageLogger",
+    cout = cms.untracked.PSet(
+        default = cms.untracked.PSet(
+            limit = cms.untracked.int32(2)
+        )
+    ),
+    destinations = cms.untracked.vstring('cout')
+)
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+process.source = cms.Source("EmptySource")
+
+process.load('Configuration.Generator.HerwigppDefaults_cfi')
+
+process.generator = cms.EDFilter("Herwig7GeneratorFilter",
+	process.herwigDefaultsBlock,
+
+	configFiles = cms.vstring(),
+
+	minimumBias = cms.vstring(
+		'cd /Herwig/MatrixElements/',
+		'insert SimpleQCD:MatrixElements[0] MEMinBias',
+		'cd /',
+		'set /Herwig/UnderlyingEvent/MPIHandler:IdenticalToUE 0',
+		'set /Herwig/Generators/LHCGenerator:EventHandler:Cuts /Herwig/Cuts/MinBiasCuts',
+	),
+
+	parameterSets = cms.vstring(
+		'cmsDefaults',
+		'minimumBias'
+	),
+
+	runModeList = cms.untracked.string(options.runModeList),
+	metricsFile = cms.untracked.string(options.metrics),
+)
+
+if options.mode == 'library':
+	process.generator.minimumBiasLibrary = cms.untracked.PSet(
+		fileName = cms.untracked.string('library.h7ce'),
+		batchSize = cms.untracked.uint32(options.batchSize),
+	)
+	process.p = cms.Path(process.generator)
+	process.schedule = cms.Schedule(process.p)
+else:
+	process.GEN = cms.OutputModule("PoolOutputModule",
+		fileName = cms.untracked.string('events.root'),
+		SelectEvents = cms.untracked.PSet(SelectEvents = cms.vstring('p'))
+	)
+	process.p = cms.Path(process.generator)
+	process.outpath = cms.EndPath(process.GEN)
+	process.schedule = cms.Schedule(process.p, process.outpath)
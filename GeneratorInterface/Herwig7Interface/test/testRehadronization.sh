@@ -0,0 +1,11 @@
+#!/bin/sh
+
+# The nominal events of a run with tune variations have to be identical to
+# the events of the same run without them.
+
+EVENTS=${EVENTS:-20}
+
+cmsRun testRehadronization_cfg.py maxEvents=$EVENTS variations=0 hashes=nominal.hashes || exit 1
+cmsRun testRehadronization_cfg.py maxEvents=$EVENTS variations=2 hashes=varied.hashes || exit 1
+
+herwig7EventHashes compare nominal.hashes varied.hashes
@@ -0,0 +1,66 @@
+import FWCore.ParameterSet.Config as cms
+from FWCore.ParameterSet.VarParsing import VarParsing
+
+# Runs the same events with and without tune variations of the hadronization.
+# The nominal events must not depend on the variations, compare the hashes of
+# both runs with testRehadronization.sh.
+
+options = VarParsing('analysis')
+options.register('variations', 0, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+	"Number of tune variations to hadronize besides the nominal event")
+options.register('hashes', 'nominal.hashes', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+	"Output file of the event hashes of the nominal events")
+options.maxEvents = 20
+options.parseArguments()
+
+process = cms.Process("TEST")
+process.load("FWCore.Framework.test.cmsExceptionsFatal_cff")
+
+process.RandomNumberGeneratorService = cms.Service("RandomNumberGeneratorService",
+    generator = cms.PSet(
+        initialSeed = cms.untracked.uint32(123456789),
+    )
+)
+
+process.MessageLogger = cms.Service("MessageLogger",
+    cout = cms.untracked.PSet(
+        default = cms.untracked.PSet(
+            limit = cms.untracked.int32(2)
+        )
+    ),
+    destinations = cms.untracked.vstring('cout')
+)
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+process.source = cms.Source("EmptySource")
+
+from GeneratorInterface.Herwig7Interface.herwigValidation_cff import *
+process.load('Configuration.Generator.HerwigppDefaults_cfi')
+
+process.generator = cms.EDFilter("Herwig7GeneratorFilter",
+	process.herwigDefaultsBlock,
+	herwigValidationBlock,
+
+	configFiles = cms.vstring(),
+
+	parameterSets = cms.vstring(
+		'cmsDefaults', 
+		'validationQCD'
+	),
+
+	eventHashes = cms.untracked.string(options.hashes),
+
+	rehadronization = cms.untracked.VPSet([
+		cms.PSet(
+			name = cms.untracked.string('reconnection%d' % i),
+			commands = cms.untracked.vstring(
+				'set /Herwig/Hadronization/ColourReconnector:ReconnectionProbability %.2f' % (0.3 + 0.1 * i)
+			),
+			dumpEvents = cms.untracked.string('reconnection%d.h7ce' % i)
+		) for i in range(options.variations)
+	]),
+)
+
+process.p = cms.Path(process.generator)
+process.schedule = cms.Schedule(process.p)